@@ -0,0 +1,154 @@
+/**
+ * Afforest connected components
+ *
+ * Finds the connected components of a large undirected graph using several
+ * threads (Sutton et al.), a refinement of Shiloach-Vishkin.
+ *
+ * Every vertex stores its parent in `comp`, with roots pointing to themselves,
+ * and trees are linked by pointing the higher root to the lower one with a
+ * compare-and-swap. The first few neighbors of every vertex are linked first,
+ * which usually already forms the largest component. That component is then
+ * identified by sampling, and its vertices skip their remaining edges, so most
+ * of the edges of the graph are never read.
+ *
+ * The graph is given in CSR form: the neighbors of `u` are `adj[offs[u]]` to
+ * `adj[offs[u + 1] - 1]`, and every edge must appear in both directions.
+ *
+ * Parameters:
+ *   - `offs`: the offsets of the neighbors of each vertex, with `n + 1`
+ *     elements;
+ *   - `adj`: the concatenated adjacency lists;
+ *   - `threads`: the number of threads to use.
+ *
+ * Returns:
+ *   - the function returns the root of the component of every vertex. It is a
+ *     valid parent array, so it can be loaded back into a `UnionFind`.
+ *
+ * Complexity:
+ *   O((n + e) * log(n) / threads) in the worst case, with `e` the number of
+ *   edges, but close to O((n + e') / threads) in practice, with `e'` the number
+ *   of edges outside the largest component.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define NEIGHBOR_ROUNDS 2
+#define NUM_SAMPLES 1024
+#define BLOCK_SIZE 4096
+
+using namespace std;
+
+typedef long long ll;
+
+// runs `f(i)` for every `i` in [0, n), handing out blocks to the threads
+template<class F> void parallelFor(int n, int threads, F f) {
+  atomic<int> next(0);
+  vector<thread> pool;
+  for(int t = 0; t < threads; t++) {
+    pool.push_back(thread([&]() {
+      for(int st; (st = next.fetch_add(BLOCK_SIZE)) < n;) {
+        for(int i = st; i < min(n, st + BLOCK_SIZE); i++) f(i);
+      }
+    }));
+  }
+  for(thread& th : pool) th.join();
+}
+
+void link(vector<atomic<int>>& comp, int u, int v) {
+  int p1 = comp[u].load(), p2 = comp[v].load();
+  while(p1 != p2) {
+    int high = max(p1, p2), low = min(p1, p2);
+    int pHigh = comp[high].load();
+    if(pHigh == low) break;
+    if(pHigh == high && comp[high].compare_exchange_strong(pHigh, low)) break;
+    p1 = comp[comp[high].load()].load();
+    p2 = comp[low].load();
+  }
+}
+
+void compress(vector<atomic<int>>& comp, int u) {
+  while(comp[comp[u].load()].load() != comp[u].load())
+    comp[u].store(comp[comp[u].load()].load());
+}
+
+inline int numThreads() { return max(1, (int) thread::hardware_concurrency()); }
+
+vector<int> afforest(const vector<ll>& offs, const vector<int>& adj,
+                     int threads = numThreads()) {
+  int n = offs.size() - 1;
+  vector<atomic<int>> comp(n);
+  parallelFor(n, threads, [&](int u) { comp[u].store(u); });
+
+  for(int r = 0; r < NEIGHBOR_ROUNDS; r++) {
+    parallelFor(n, threads, [&](int u) {
+      if(offs[u] + r < offs[u + 1]) link(comp, u, adj[offs[u] + r]);
+    });
+    parallelFor(n, threads, [&](int u) { compress(comp, u); });
+  }
+
+  // the most frequent root is very likely the largest component
+  int largest = 0, best = 0;
+  if(n > 0) {
+    unordered_map<int, int> cnt;
+    for(int i = 0; i < NUM_SAMPLES; i++) {
+      int c = comp[rand() % n].load();
+      if(++cnt[c] > best) { best = cnt[c]; largest = c; }
+    }
+  }
+
+  parallelFor(n, threads, [&](int u) {
+    if(comp[u].load() == largest) return;
+    for(ll e = offs[u] + NEIGHBOR_ROUNDS; e < offs[u + 1]; e++)
+      link(comp, u, adj[e]);
+  });
+  parallelFor(n, threads, [&](int u) { compress(comp, u); });
+
+  vector<int> res(n);
+  for(int u = 0; u < n; u++) res[u] = comp[u].load();
+  return res;
+}
+
+// -----------------------------------------------
+
+#include <cassert>
+
+int main() {
+  // a grid of `side` x `side` vertices connected along rows, plus a column
+  // connecting only the even rows
+  int side = 300, n = side * side;
+  vector<pair<int, int>> edges;
+  for(int r = 0; r < side; r++) {
+    for(int c = 0; c + 1 < side; c++)
+      edges.push_back(make_pair(r * side + c, r * side + c + 1));
+  }
+  for(int r = 0; r + 2 < side; r += 2)
+    edges.push_back(make_pair(r * side, (r + 2) * side));
+
+  vector<ll> offs(n + 1);
+  for(auto& e : edges) { offs[e.first + 1]++; offs[e.second + 1]++; }
+  for(int u = 0; u < n; u++) offs[u + 1] += offs[u];
+  vector<int> adj(offs[n]);
+  vector<ll> pos(offs.begin(), offs.end() - 1);
+  for(auto& e : edges) {
+    adj[pos[e.first]++] = e.second;
+    adj[pos[e.second]++] = e.first;
+  }
+
+  vector<int> comp = afforest(offs, adj, 4);
+  assert(comp == afforest(offs, adj, 1));
+  for(int r = 0; r < side; r++) {
+    for(int c = 0; c < side; c++) {
+      int u = r * side + c;
+      assert(comp[comp[u]] == comp[u]);
+      assert(comp[u] == (r % 2 == 0 ? comp[0] : comp[r * side]));
+    }
+    if(r % 2 == 1) assert(comp[r * side] != comp[0]);
+  }
+  return 0;
+}
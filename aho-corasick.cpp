@@ -0,0 +1,162 @@
+/**
+ * Aho-Corasick algorithm
+ *
+ * Searches for occurrences of several patterns within a string in a single
+ * pass, using an automaton built from a trie of the patterns where each node
+ * knows where to continue when a mismatch occurs (its failure link) and which
+ * is the longest pattern ending at a proper suffix of it (its dictionary link).
+ *
+ * Nodes close to the root, or with many children, store a full transition row
+ * for all 256 characters. Every other node stores its children sorted by
+ * character and falls back to the failure link when a character is missing.
+ *
+ * Parameters:
+ *   - `patterns`: the patterns to find;
+ *   - `str`: the string to search;
+ *   - `f`: a callback receiving the starting index of each match and the index
+ *     of the pattern matched;
+ *   - `res`: the vector to be filled with the results.
+ *
+ * Operations:
+ *   - `build(patterns)` builds the automaton for the given patterns;
+ *   - `forEach(str, f)` calls `f` for every match in `str`;
+ *   - `search(str, res)` fills `res` with (index, pattern) pairs for every
+ *     match in `str`.
+ *
+ * Returns:
+ *   - matches are reported by increasing end index and, for the same end index,
+ *     by decreasing length. As in KMP, matches may overlap.
+ *
+ * Complexity:
+ *   - Space: O(k + 256 * d), where `k` is the total length of the patterns and
+ *     `d` the number of nodes with a full transition row;
+ *   - Time:
+ *       * `build`: O(k * log(256) + 256 * d);
+ *       * `forEach`, `search`: O(n * log(256) + m), with `n == str.length()`
+ *         and `m` the number of matches.
+ */
+
+#include <algorithm>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define DENSE_DEPTH 2
+#define DENSE_DEGREE 32
+
+using namespace std;
+
+struct AhoCorasick {
+  vector<int> fail, dict, term, len, samePat;
+  vector<int> dense, rows;                // full rows, -1 if sparse
+  vector<int> edgeSt, edgeTo;             // children sorted by character
+  vector<unsigned char> edgeChr;
+
+  int child(int u, unsigned char c) {
+    int lo = edgeSt[u], hi = edgeSt[u + 1];
+    while(lo < hi) {
+      int mid = (lo + hi) / 2;
+      if(edgeChr[mid] < c) lo = mid + 1; else hi = mid;
+    }
+    return lo < edgeSt[u + 1] && edgeChr[lo] == c ? edgeTo[lo] : -1;
+  }
+
+  int next(int u, unsigned char c) {
+    while(true) {
+      if(dense[u] >= 0) return rows[dense[u] * 256 + c];
+      int v = child(u, c);
+      if(v >= 0) return v;
+      u = fail[u];
+    }
+  }
+
+  void build(const vector<string>& patterns) {
+    vector<vector<pair<unsigned char, int>>> trie(1);
+    term.assign(1, -1); len.assign(1, 0);
+    samePat.assign(patterns.size(), -1);
+
+    for(int p = 0; p < (int) patterns.size(); p++) {
+      int u = 0;
+      for(unsigned char c : patterns[p]) {
+        int v = -1;
+        for(auto& e : trie[u]) if(e.first == c) { v = e.second; break; }
+        if(v < 0) {
+          v = trie.size();
+          trie[u].push_back(make_pair(c, v));
+          trie.push_back(vector<pair<unsigned char, int>>());
+          term.push_back(-1); len.push_back(len[u] + 1);
+        }
+        u = v;
+      }
+      samePat[p] = term[u]; term[u] = p;
+    }
+
+    int n = trie.size();
+    edgeSt.assign(n + 1, 0); edgeTo.clear(); edgeChr.clear();
+    for(int u = 0; u < n; u++) {
+      sort(trie[u].begin(), trie[u].end());
+      for(auto& e : trie[u]) {
+        edgeChr.push_back(e.first); edgeTo.push_back(e.second);
+      }
+      edgeSt[u + 1] = edgeTo.size();
+    }
+
+    fail.assign(n, 0); dict.assign(n, -1); dense.assign(n, -1); rows.clear();
+    queue<int> q; q.push(0);
+    while(!q.empty()) {
+      int u = q.front(); q.pop();
+
+      // the root always gets a full row, so that `next` always terminates
+      if(u == 0 || len[u] < DENSE_DEPTH || trie[u].size() >= DENSE_DEGREE) {
+        int row = dense[u] = rows.size() / 256;
+        rows.resize(rows.size() + 256);
+        for(int c = 0; c < 256; c++) {
+          int v = child(u, c);
+          rows[row * 256 + c] = v >= 0 ? v : u == 0 ? 0 : next(fail[u], c);
+        }
+      }
+
+      for(auto& e : trie[u]) {
+        int v = e.second;
+        fail[v] = u == 0 ? 0 : next(fail[u], e.first);
+        dict[v] = term[fail[v]] >= 0 ? fail[v] : dict[fail[v]];
+        q.push(v);
+      }
+    }
+  }
+
+  template<class F> void forEach(const string& str, F f) {
+    int u = 0;
+    for(int i = 0; i < (int) str.size(); i++) {
+      u = next(u, str[i]);
+      for(int v = term[u] >= 0 ? u : dict[u]; v >= 0; v = dict[v]) {
+        for(int p = term[v]; p >= 0; p = samePat[p])
+          f(i - len[v] + 1, p);
+      }
+    }
+  }
+
+  void search(const string& str, vector<pair<int, int>>& res) {
+    res.clear();
+    forEach(str, [&](int idx, int p) { res.push_back(make_pair(idx, p)); });
+  }
+};
+
+// -----------------------------------------------
+
+#include <iostream>
+
+int main() {
+  AhoCorasick ac;
+  ac.build({"he", "she", "his", "hers", "he"});
+
+  vector<pair<int, int>> res;
+  ac.search("ahishers", res);
+
+  cout << "Expected: (1,2) (3,1) (4,4) (4,0) (4,3)" << endl;
+  cout << "  Result: ";
+  for(auto& m : res) cout << "(" << m.first << "," << m.second << ") ";
+  cout << endl;
+  return 0;
+}
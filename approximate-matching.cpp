@@ -0,0 +1,172 @@
+/**
+ * Approximate string matching (Shift-And and Myers' algorithms)
+ *
+ * Searches for occurrences of `pattern` within `str` allowing up to `k` errors,
+ * keeping the state of the match for every prefix of the pattern as bits of
+ * machine words so that a whole column is updated with a few word operations.
+ *
+ * `shiftAnd` allows `k` mismatches (substitutions only), keeping one bitmask of
+ * matched prefixes per number of errors. `myers` allows `k` edits (insertions,
+ * deletions and substitutions), encoding a column of the edit distance matrix
+ * as its vertical differences. Patterns with more than 64 characters are split
+ * into several words, carrying bits between them.
+ *
+ * Parameters:
+ *   - `str`: the string to search;
+ *   - `pattern`: the pattern to find in the string;
+ *   - `k`: the maximum number of errors allowed;
+ *   - `res`: the vector to be filled with the results.
+ *
+ * Returns:
+ *   - `shiftAnd`: `res` is filled with the starting indices of all the
+ *     (possibly overlapping) substrings of length `pattern.length()` differing
+ *     from `pattern` in at most `k` positions;
+ *   - `myers`: `res` is filled with the ending indices of all the substrings
+ *     within edit distance `k` of `pattern`.
+ *   An empty pattern matches everywhere: at every index in [0, n] for
+ *   `shiftAnd` and at every index in [0, n) for `myers`.
+ *
+ * Complexity:
+ *   - `shiftAnd`: O(n * k * w);
+ *   - `myers`: O(n * w),
+ *   with `n == str.length()` and `w == ceil(pattern.length() / 64)`.
+ */
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef unsigned long long ull;
+
+void shiftAnd(const string& str, const string& pattern, int k,
+              vector<int>& res) {
+  res.clear();
+  int m = pattern.size(), w = (m + 63) / 64;
+  if(m == 0) {
+    for(int i = 0; i <= (int) str.size(); i++) res.push_back(i);
+    return;
+  }
+  ull last = 1ULL << ((m - 1) % 64);
+
+  vector<ull> mask(256 * w);
+  for(int i = 0; i < m; i++)
+    mask[(unsigned char) pattern[i] * w + i / 64] |= 1ULL << (i % 64);
+
+  if(w == 1) {
+    vector<ull> r(k + 1);
+    for(int i = 0; i < (int) str.size(); i++) {
+      ull eq = mask[(unsigned char) str[i]], prev = 0;
+      for(int j = 0; j <= k; j++) {
+        ull cur = r[j];
+        r[j] = ((cur << 1 | 1) & eq) | (j ? prev << 1 | 1 : 0);
+        prev = cur;
+      }
+      if(r[k] & last) res.push_back(i - m + 1);
+    }
+    return;
+  }
+
+  vector<ull> r((k + 1) * w), prev(w);
+  for(int i = 0; i < (int) str.size(); i++) {
+    const ull* eq = &mask[(unsigned char) str[i] * w];
+    for(int j = 0; j <= k; j++) {
+      ull* cur = &r[j * w];
+      ull carry = 1, prevCarry = 1;
+      for(int b = 0; b < w; b++) {
+        ull old = cur[b];
+        cur[b] = ((old << 1 | carry) & eq[b]) |
+            (j ? prev[b] << 1 | prevCarry : 0);
+        carry = old >> 63; prevCarry = prev[b] >> 63;
+        prev[b] = old;
+      }
+    }
+    if(r[k * w + w - 1] & last) res.push_back(i - m + 1);
+  }
+}
+
+void myers(const string& str, const string& pattern, int k, vector<int>& res) {
+  res.clear();
+  int m = pattern.size(), w = (m + 63) / 64;
+  if(m == 0) {
+    for(int i = 0; i < (int) str.size(); i++) res.push_back(i);
+    return;
+  }
+  ull last = 1ULL << ((m - 1) % 64);
+
+  vector<ull> peq(256 * w);
+  for(int i = 0; i < m; i++)
+    peq[(unsigned char) pattern[i] * w + i / 64] |= 1ULL << (i % 64);
+
+  // vertical positive and negative differences of the current column
+  vector<ull> pv(w, ~0ULL), mv(w, 0);
+  int score = m;
+
+  for(int i = 0; i < (int) str.size(); i++) {
+    const ull* eqs = &peq[(unsigned char) str[i] * w];
+    int hin = 0;  // horizontal difference entering the block from above
+    for(int b = 0; b < w; b++) {
+      ull eq = eqs[b], high = b == w - 1 ? last : 1ULL << 63;
+      ull xv = eq | mv[b];
+      if(hin < 0) eq |= 1;
+      ull xh = (((eq & pv[b]) + pv[b]) ^ pv[b]) | eq;
+      ull ph = mv[b] | ~(xh | pv[b]);
+      ull mh = pv[b] & xh;
+
+      int hout = (ph & high) ? 1 : (mh & high) ? -1 : 0;
+      ph <<= 1; mh <<= 1;
+      if(hin < 0) mh |= 1; else if(hin > 0) ph |= 1;
+
+      pv[b] = mh | ~(xv | ph);
+      mv[b] = ph & xv;
+      hin = hout;
+    }
+    score += hin;
+    if(score <= k) res.push_back(i);
+  }
+}
+
+// -----------------------------------------------
+
+#include <iostream>
+
+void print(const vector<int>& res) {
+  for(int idx : res) cout << idx << " ";
+  cout << endl;
+}
+
+int main() {
+  vector<int> res;
+  shiftAnd("AABAACAADAABAAABAA", "AABA", 1, res);
+  cout << "Expected: 0 3 6 9 13" << endl;
+  cout << "  Result: "; print(res);
+
+  myers("AABAACAADAABAAABAA", "AABA", 1, res);
+  cout << "Expected: 2 3 4 6 9 11 12 13 14 15 16 17" << endl;
+  cout << "  Result: "; print(res);
+
+  string text(200, 'A'), pattern(100, 'A');
+  text[40] = text[120] = 'B';
+  pattern[50] = 'B';
+
+  shiftAnd(text, pattern, 1, res);
+  cout << "Expected: 70" << endl;
+  cout << "  Result: "; print(res);
+
+  myers(text, pattern, 0, res);
+  cout << "Expected: 169" << endl;
+  cout << "  Result: "; print(res);
+
+  myers(text, pattern, 1, res);
+  cout << "Expected: 168 169 170" << endl;
+  cout << "  Result: "; print(res);
+
+  shiftAnd("ABC", "", 0, res);
+  cout << "Expected: 0 1 2 3" << endl;
+  cout << "  Result: "; print(res);
+
+  myers("ABC", "", 0, res);
+  cout << "Expected: 0 1 2" << endl;
+  cout << "  Result: "; print(res);
+  return 0;
+}
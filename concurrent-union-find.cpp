@@ -0,0 +1,124 @@
+/**
+ * Concurrent Union-Find structure
+ *
+ * Lock-free version of the union-find structure that allows several threads to
+ * join and query subsets at the same time (Jayanti-Tarjan / Anderson-Woll).
+ *
+ * Each element stores its parent in `pset`, and the representative of each
+ * subset points to itself. Two representatives are linked with a single
+ * compare-and-swap on the one with the lowest priority, which only succeeds if
+ * it is still a representative. Priorities are a fixed pseudo-random
+ * permutation of the indices, so links never form cycles and trees stay
+ * shallow with high probability. Paths are halved with compare-and-swap too, so
+ * a thread only ever replaces a parent by one of its ancestors.
+ *
+ * Parameters:
+ *   - `T` (type): the signed integer type used for the elements, `int` by
+ *                 default.
+ *
+ * Operations:
+ *   - `init(T n)` sets the initial state for `n` elements, where each one
+ *     belongs to its own subset. Must not run concurrently with other
+ *     operations;
+ *   - `get(T i)` returns the current subset of element `i`;
+ *   - `join(T i, T j)` merges the subsets of elements `i` and `j`, returning
+ *     `false` if they were already the same;
+ *   - `sameSet(T i, T j)` returns if `i` and `j` belong to the same subset;
+ *   - `countSets()` returns the current number of subsets.
+ *
+ * Complexity:
+ *   - Space: O(n);
+ *   - Time:
+ *       * `init`: O(n);
+ *       * `get`, `join`, `sameSet`: O(log(n)) with high probability, with
+ *         near-linear speedup as long as threads rarely touch the same roots;
+ *       * `countSets`: O(n).
+ */
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+template<class T = int> struct ConcurrentUnionFind {
+  vector<atomic<T>> pset;
+
+  ConcurrentUnionFind() {}
+  ConcurrentUnionFind(T n) {
+    init(n);
+  }
+
+  void init(T n) {
+    pset = vector<atomic<T>>(n);
+    for(T i = 0; i < n; i++) pset[i].store(i);
+  }
+
+  static unsigned long long priority(T i) {
+    return (unsigned long long) i * 0x9E3779B97F4A7C15ULL;
+  }
+
+  T get(T i) {
+    while(true) {
+      T p = pset[i].load();
+      if(p == i) return i;
+      T gp = pset[p].load();
+      if(p != gp) pset[i].compare_exchange_weak(p, gp);
+      i = gp;
+    }
+  }
+
+  bool join(T i, T j) {
+    while(true) {
+      i = get(i); j = get(j);
+      if(i == j) return false;
+      if(priority(i) > priority(j)) swap(i, j);
+      T expected = i;
+      if(pset[i].compare_exchange_strong(expected, j)) return true;
+    }
+  }
+
+  bool sameSet(T i, T j) {
+    while(true) {
+      i = get(i); j = get(j);
+      if(i == j) return true;
+      // `i` was still a root after `j` was found, so they were apart then
+      if(pset[i].load() == i) return false;
+    }
+  }
+
+  T countSets() {
+    T cnt = 0;
+    for(T i = 0; i < (T) pset.size(); i++) if(pset[i].load() == i) cnt++;
+    return cnt;
+  }
+};
+
+// -----------------------------------------------
+
+#include <cassert>
+#include <thread>
+
+int main() {
+  int n = 1000000, threads = 4;
+  ConcurrentUnionFind<> uf(n);
+
+  // every thread joins a strided share of the edges (i, i + 2)
+  vector<thread> pool;
+  for(int t = 0; t < threads; t++) {
+    pool.push_back(thread([&, t]() {
+      for(int i = t; i + 2 < n; i += threads) uf.join(i, i + 2);
+    }));
+  }
+  for(thread& th : pool) th.join();
+
+  assert(uf.countSets() == 2);
+  assert(uf.sameSet(0, n - 2));
+  assert(uf.sameSet(1, n - 1));
+  assert(!uf.sameSet(0, 1));
+  assert(!uf.join(4, 8));
+  assert(uf.join(0, 1));
+  assert(uf.countSets() == 1);
+
+  return 0;
+}
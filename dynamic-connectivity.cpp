@@ -0,0 +1,193 @@
+/**
+ * Offline dynamic connectivity
+ *
+ * Answers connectivity queries on a graph whose edges are both added and
+ * removed over time, given the whole sequence of operations in advance.
+ *
+ * Each edge is alive during an interval of time, which is split into O(log(q))
+ * nodes of a segment tree over time. A depth-first traversal of the tree joins
+ * the edges of each node when entering it and undoes them when leaving, so at
+ * each leaf the union-find structure holds exactly the edges alive at that
+ * time. Undoing is done by a union-find with rollback, which merges by size
+ * and does not compress paths so that every join changes only two entries.
+ *
+ * Parameters:
+ *   - `n`: the number of vertices.
+ *
+ * Operations (RollbackUnionFind):
+ *   - `init(int n)`, `get(int i)`, `join(int i, int j)`, `sameSet(int i, int j)`
+ *     and `sets`, as in the regular union-find structure;
+ *   - `snapshot()` returns a handle for the current state;
+ *   - `rollback(int snap)` undoes all joins made after `snapshot()` returned
+ *     `snap`.
+ *
+ * Operations (DynamicConnectivity):
+ *   - `addEdge(int u, int v)` adds an edge between `u` and `v`;
+ *   - `removeEdge(int u, int v)` removes an edge previously added between `u`
+ *     and `v`;
+ *   - `query(int u, int v)` asks whether `u` and `v` are connected at this
+ *     point of the sequence;
+ *   - `solve(int n)` returns the answers to all the queries, in order.
+ *
+ * Complexity:
+ *   - Space: O(n + q * log(q)), with `q` the number of operations;
+ *   - Time:
+ *       * `get`, `join`, `sameSet`: O(log(n));
+ *       * `rollback`: O(1) per join undone;
+ *       * `solve`: O((n + q * log(q)) * log(n)).
+ */
+
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+struct RollbackUnionFind {
+  vector<int> pset;            // parent, or -(size) for roots
+  vector<pair<int, int>> hist; // (linked root, its old entry) for each join
+  int sets;
+
+  RollbackUnionFind() {}
+  RollbackUnionFind(int n) {
+    init(n);
+  }
+
+  void init(int n) {
+    pset.assign(n, -1);
+    hist.clear();
+    sets = n;
+  }
+
+  int get(int i) {
+    while(pset[i] >= 0) i = pset[i];
+    return i;
+  }
+
+  bool join(int i, int j) {
+    int xRoot = get(i);
+    int yRoot = get(j);
+    if (xRoot == yRoot) return false;
+    if (pset[xRoot] > pset[yRoot]) swap(xRoot, yRoot);
+    hist.push_back(make_pair(yRoot, pset[yRoot]));
+    pset[xRoot] += pset[yRoot];
+    pset[yRoot] = xRoot;
+    sets--;
+    return true;
+  }
+
+  bool sameSet(int i, int j) {
+    return get(i) == get(j);
+  }
+
+  int snapshot() { return hist.size(); }
+
+  void rollback(int snap) {
+    while((int) hist.size() > snap) {
+      int yRoot = hist.back().first, xRoot = pset[yRoot];
+      pset[xRoot] -= hist.back().second;
+      pset[yRoot] = hist.back().second;
+      hist.pop_back();
+      sets++;
+    }
+  }
+};
+
+struct DynamicConnectivity {
+  struct Op { int type, u, v; };  // type: 0 add, 1 remove, 2 query
+  vector<Op> ops;
+
+  vector<vector<pair<int, int>>> tree;
+  RollbackUnionFind uf;
+  vector<bool> answers;
+
+  void addEdge(int u, int v) { ops.push_back({0, min(u, v), max(u, v)}); }
+  void removeEdge(int u, int v) { ops.push_back({1, min(u, v), max(u, v)}); }
+  void query(int u, int v) { ops.push_back({2, u, v}); }
+
+  inline int left(int node) { return 2 * node; }
+  inline int right(int node) { return 2 * node + 1; }
+
+  // adds the edge to the nodes covering the times [i, j]
+  void insert(int node, int st, int end, int i, int j, pair<int, int> e) {
+    if (j < st || i > end) return;
+    if (st >= i && end <= j) { tree[node].push_back(e); return; }
+    insert(left(node), st, (st + end) / 2, i, j, e);
+    insert(right(node), (st + end) / 2 + 1, end, i, j, e);
+  }
+
+  void dfs(int node, int st, int end) {
+    int snap = uf.snapshot();
+    for(auto& e : tree[node]) uf.join(e.first, e.second);
+
+    if (st == end) {
+      if(ops[st].type == 2)
+        answers.push_back(uf.sameSet(ops[st].u, ops[st].v));
+    } else {
+      dfs(left(node), st, (st + end) / 2);
+      dfs(right(node), (st + end) / 2 + 1, end);
+    }
+    uf.rollback(snap);
+  }
+
+  vector<bool> solve(int n) {
+    int q = ops.size();
+    answers.clear();
+    if(q == 0) return answers;
+
+    tree.assign(4 * q + 1, vector<pair<int, int>>());
+    map<pair<int, int>, vector<int>> open;  // start times of alive edges
+    for(int t = 0; t < q; t++) {
+      pair<int, int> e = make_pair(ops[t].u, ops[t].v);
+      if(ops[t].type == 0) open[e].push_back(t);
+      else if(ops[t].type == 1) {
+        insert(1, 0, q - 1, open[e].back(), t - 1, e);
+        open[e].pop_back();
+      }
+    }
+    for(auto& kv : open) {
+      for(int st : kv.second) insert(1, 0, q - 1, st, q - 1, kv.first);
+    }
+
+    uf.init(n);
+    dfs(1, 0, q - 1);
+    return answers;
+  }
+};
+
+// -----------------------------------------------
+
+#include <cassert>
+
+int main() {
+  RollbackUnionFind uf(5);
+  uf.join(0, 1);
+  int snap = uf.snapshot();
+  uf.join(1, 2); uf.join(3, 4);
+  assert(uf.sameSet(0, 2) && uf.sets == 2);
+  uf.rollback(snap);
+  assert(uf.sameSet(0, 1) && !uf.sameSet(0, 2) && !uf.sameSet(3, 4));
+  assert(uf.sets == 4);
+
+  DynamicConnectivity dc;
+  dc.addEdge(0, 1);
+  dc.addEdge(1, 2);
+  dc.query(0, 2);     // true
+  dc.removeEdge(1, 0);
+  dc.query(0, 2);     // false
+  dc.addEdge(2, 3);
+  dc.addEdge(0, 3);
+  dc.query(0, 1);     // true
+  dc.removeEdge(0, 3);
+  dc.query(0, 1);     // false
+  dc.addEdge(1, 2);
+  dc.removeEdge(1, 2);
+  dc.query(1, 3);     // true, a copy of (1, 2) is still there
+  dc.removeEdge(2, 1);
+  dc.query(1, 3);     // false
+
+  vector<bool> res = dc.solve(4);
+  assert(res == vector<bool>({true, false, true, false, true, false}));
+
+  return 0;
+}
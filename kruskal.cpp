@@ -0,0 +1,231 @@
+/**
+ * Filter-Kruskal minimum spanning forest
+ *
+ * Finds a minimum spanning forest of an undirected weighted graph. Kruskal's
+ * algorithm sorts all the edges and adds them by increasing weight as long as
+ * they join two different components. Filter-Kruskal (Osipov et al.) instead
+ * partitions the edges around a pivot weight, solves the light half first and
+ * then discards the heavy edges that are already inside a component before
+ * recursing on them, so most of the heavy edges never get sorted. Partitions
+ * and sorts of large ranges are split across threads.
+ *
+ * Edges can be read from a binary file holding an array of `Edge`, which is
+ * mapped into memory privately so that it can be reordered in place without
+ * changing the file.
+ *
+ * Parameters:
+ *   - `n`: the number of vertices;
+ *   - `edges`: the edges of the graph, which get reordered;
+ *   - `m`: the number of edges;
+ *   - `threads`: the number of threads to use;
+ *   - `path`: the binary file with the edges.
+ *
+ * Returns:
+ *   - `filterKruskal` returns the total weight of the forest and fills `mst`
+ *     with its edges;
+ *   - `mapEdges` returns a pointer to the edges in `path` and sets `m` to their
+ *     number, or returns NULL if the file could not be mapped.
+ *
+ * Complexity:
+ *   O(m + n * log(n) * log(m / n)) expected for random weights, and
+ *   O(m * log(m)) in the worst case.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#define KRUSKAL_THRESHOLD 4096
+#define PARALLEL_THRESHOLD 100000
+
+using namespace std;
+
+typedef long long ll;
+
+struct Edge {
+  int u, v;
+  double w;
+  bool operator<(const Edge& o) const { return w < o.w; }
+};
+
+// iterative union-find, as in union-find.cpp
+struct UnionFind {
+  vector<int> pset;
+
+  UnionFind(int n) : pset(n, -1) {}
+
+  int get(int i) {
+    while(pset[i] >= 0) {
+      int p = pset[i];
+      if(pset[p] < 0) return p;
+      i = pset[i] = pset[p];
+    }
+    return i;
+  }
+
+  bool join(int i, int j) {
+    int xRoot = get(i);
+    int yRoot = get(j);
+    if (xRoot == yRoot) return false;
+    if (pset[xRoot] > pset[yRoot]) swap(xRoot, yRoot);
+    pset[xRoot] += pset[yRoot];
+    pset[yRoot] = xRoot;
+    return true;
+  }
+};
+
+inline int numThreads() { return max(1, (int) thread::hardware_concurrency()); }
+
+void parallelSort(Edge* e, ll m, int threads) {
+  if(m < PARALLEL_THRESHOLD || threads == 1) { sort(e, e + m); return; }
+
+  vector<ll> bounds(threads + 1);
+  for(int t = 0; t <= threads; t++) bounds[t] = m * t / threads;
+  vector<thread> pool;
+  for(int t = 0; t < threads; t++)
+    pool.push_back(thread([=]() { sort(e + bounds[t], e + bounds[t + 1]); }));
+  for(thread& th : pool) th.join();
+
+  // merge pairs of adjacent sorted runs until a single one is left
+  for(int step = 1; step < threads; step *= 2) {
+    pool.clear();
+    for(int t = 0; t + step < threads; t += 2 * step) {
+      ll st = bounds[t], mid = bounds[t + step];
+      ll end = bounds[min(threads, t + 2 * step)];
+      pool.push_back(thread([=]() {
+        inplace_merge(e + st, e + mid, e + end);
+      }));
+    }
+    for(thread& th : pool) th.join();
+  }
+}
+
+// moves the edges with weight <= `pivot` to the front using `tmp` as buffer,
+// returning how many they are
+ll parallelPartition(Edge* e, Edge* tmp, ll m, double pivot, int threads) {
+  if(m < PARALLEL_THRESHOLD || threads == 1) {
+    return partition(e, e + m, [&](const Edge& x) { return x.w <= pivot; }) - e;
+  }
+
+  vector<ll> bounds(threads + 1), light(threads + 1), heavy(threads + 1);
+  for(int t = 0; t <= threads; t++) bounds[t] = m * t / threads;
+  vector<thread> pool;
+  for(int t = 0; t < threads; t++) {
+    pool.push_back(thread([&, t]() {
+      for(ll i = bounds[t]; i < bounds[t + 1]; i++)
+        (e[i].w <= pivot ? light : heavy)[t + 1]++;
+    }));
+  }
+  for(thread& th : pool) th.join();
+  for(int t = 0; t < threads; t++) {
+    light[t + 1] += light[t];
+    heavy[t + 1] += heavy[t];
+  }
+
+  pool.clear();
+  for(int t = 0; t < threads; t++) {
+    pool.push_back(thread([&, t]() {
+      ll l = light[t], h = light[threads] + heavy[t];
+      for(ll i = bounds[t]; i < bounds[t + 1]; i++)
+        tmp[e[i].w <= pivot ? l++ : h++] = e[i];
+    }));
+  }
+  for(thread& th : pool) th.join();
+  copy(tmp, tmp + m, e);
+  return light[threads];
+}
+
+double kruskal(UnionFind& uf, Edge* e, ll m, vector<Edge>& mst, int threads) {
+  parallelSort(e, m, threads);
+  double total = 0;
+  for(ll i = 0; i < m; i++) {
+    if(uf.join(e[i].u, e[i].v)) { mst.push_back(e[i]); total += e[i].w; }
+  }
+  return total;
+}
+
+double filterKruskal(UnionFind& uf, Edge* e, Edge* tmp, ll m,
+                     vector<Edge>& mst, int threads) {
+  if(m <= KRUSKAL_THRESHOLD) return kruskal(uf, e, m, mst, threads);
+
+  double a = e[rand() % m].w, b = e[rand() % m].w, c = e[rand() % m].w;
+  double pivot = max(min(a, b), min(max(a, b), c));
+  ll light = parallelPartition(e, tmp, m, pivot, threads);
+  if(light == m) return kruskal(uf, e, m, mst, threads);
+
+  double total = filterKruskal(uf, e, tmp, light, mst, threads);
+  Edge* heavy = e + light;
+  ll kept = partition(heavy, e + m, [&](const Edge& x) {
+    return uf.get(x.u) != uf.get(x.v);
+  }) - heavy;
+  return total + filterKruskal(uf, heavy, tmp + light, kept, mst, threads);
+}
+
+double filterKruskal(int n, Edge* edges, ll m, vector<Edge>& mst,
+                     int threads = numThreads()) {
+  UnionFind uf(n);
+  vector<Edge> tmp(m);
+  mst.clear();
+  return filterKruskal(uf, edges, tmp.data(), m, mst, threads);
+}
+
+Edge* mapEdges(const char* path, ll& m) {
+  int fd = open(path, O_RDONLY);
+  if(fd < 0) return NULL;
+  struct stat st;
+  if(fstat(fd, &st) < 0 || st.st_size == 0) { close(fd); return NULL; }
+
+  void* data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    fd, 0);
+  close(fd);
+  if(data == MAP_FAILED) return NULL;
+  madvise(data, st.st_size, MADV_SEQUENTIAL);
+  m = st.st_size / sizeof(Edge);
+  return (Edge*) data;
+}
+
+// -----------------------------------------------
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+
+int main() {
+  int n = 20000;
+  ll m = 400000;
+  vector<Edge> edges(m);
+  for(ll i = 0; i < m; i++) {
+    // the first edges form a random tree, so that the graph is connected
+    edges[i].u = i < n - 1 ? i + 1 : rand() % n;
+    edges[i].v = i < n - 1 ? rand() % (i + 1) : rand() % n;
+    edges[i].w = rand() % 1000000;
+  }
+
+  FILE* f = fopen("/tmp/kruskal.edges", "wb");
+  fwrite(edges.data(), sizeof(Edge), m, f);
+  fclose(f);
+
+  vector<Edge> copyEdges(edges), mst;
+  UnionFind uf(n);
+  double expected = kruskal(uf, copyEdges.data(), m, mst, 1);
+
+  double total = filterKruskal(n, edges.data(), m, mst, 4);
+  assert((int) mst.size() == n - 1);
+  assert(fabs(total - expected) < 1e-6);
+
+  ll mapped;
+  Edge* fileEdges = mapEdges("/tmp/kruskal.edges", mapped);
+  assert(fileEdges != NULL && mapped == m);
+  assert(fabs(filterKruskal(n, fileEdges, mapped, mst) - expected) < 1e-6);
+  munmap(fileEdges, mapped * sizeof(Edge));
+  unlink("/tmp/kruskal.edges");
+
+  printf("MST weight: %.0lf\n", total);
+  return 0;
+}
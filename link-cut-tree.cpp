@@ -0,0 +1,278 @@
+/**
+ * Link-Cut Tree
+ *
+ * Data structure that maintains a forest under edge insertions and deletions,
+ * answering connectivity and aggregated path queries (Sleator-Tarjan).
+ *
+ * Each tree is split into preferred paths, each one stored in a splay tree
+ * ordered by depth. `access(x)` makes the path from the root to `x` preferred,
+ * after which the whole path is a single splay tree. Rerooting a tree reverses
+ * one of these paths, so every node keeps the aggregate of its splay subtree
+ * in both directions. Nodes are stored in arrays indexed by vertex, with index
+ * `n` as a null sentinel holding the identity value.
+ *
+ * Parameters:
+ *   - `Node` (type): a class holding the information to aggregate along paths.
+ *                    Must implement:
+ *       * A default constructor, returning the identity value;
+ *       * A member `Node join(Node& node)`, returning a new `Node` with the
+ *         merged data of this node followed by the argument.
+ *   - `n`: the number of vertices.
+ *
+ * Operations:
+ *   - `link(int u, int v)` adds an edge between `u` and `v`, returning `false`
+ *     if they were already connected;
+ *   - `cut(int u, int v)` removes the edge between `u` and `v`, returning
+ *     `false` if there was none;
+ *   - `connected(int u, int v)` returns if `u` and `v` are in the same tree;
+ *   - `pathAggregate(int u, int v)` returns the join of the values of the
+ *     vertices in the path from `u` to `v`, in order;
+ *   - `lca(int root, int u, int v)` returns the lowest common ancestor of `u`
+ *     and `v` when their tree is rooted at `root`;
+ *   - `set(int u, Node val)` changes the value of vertex `u`.
+ *
+ * Complexity:
+ *   - Space: O(n);
+ *   - Time: Amortized O(log(n)) for every operation.
+ */
+
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+template<class Node> struct LinkCutTree {
+  int n;
+  vector<int> left, right, par;
+  vector<char> flipped;  // children still have to be reversed
+  vector<Node> val, sum, rsum;
+  vector<int> stk;
+
+  LinkCutTree(int n): n(n), left(n + 1, n), right(n + 1, n), par(n + 1, n),
+      flipped(n + 1), val(n + 1), sum(n + 1), rsum(n + 1), stk(n + 1) {}
+
+  inline bool isRoot(int x) { return left[par[x]] != x && right[par[x]] != x; }
+
+  void flip(int x) {
+    swap(left[x], right[x]);
+    swap(sum[x], rsum[x]);
+    flipped[x] = !flipped[x];
+  }
+
+  void push(int x) {
+    if(flipped[x]) {
+      if(left[x] != n) flip(left[x]);
+      if(right[x] != n) flip(right[x]);
+      flipped[x] = false;
+    }
+  }
+
+  void pull(int x) {
+    Node a = sum[left[x]].join(val[x]);
+    sum[x] = a.join(sum[right[x]]);
+    Node b = rsum[right[x]].join(val[x]);
+    rsum[x] = b.join(rsum[left[x]]);
+  }
+
+  void rotate(int x) {
+    int p = par[x], g = par[p];
+    if(!isRoot(p)) (left[g] == p ? left[g] : right[g]) = x;
+    par[x] = g;
+    if(left[p] == x) {
+      left[p] = right[x];
+      if(right[x] != n) par[right[x]] = p;
+      right[x] = p;
+    } else {
+      right[p] = left[x];
+      if(left[x] != n) par[left[x]] = p;
+      left[x] = p;
+    }
+    par[p] = x;
+    pull(p); pull(x);
+  }
+
+  void splay(int x) {
+    int top = 0;
+    stk[top++] = x;
+    for(int y = x; !isRoot(y); y = par[y]) stk[top++] = par[y];
+    while(top > 0) push(stk[--top]);
+
+    while(!isRoot(x)) {
+      int p = par[x], g = par[p];
+      if(!isRoot(p)) rotate((left[g] == p) == (left[p] == x) ? p : x);
+      rotate(x);
+    }
+  }
+
+  // makes the path from the root to `x` preferred, returning the last node
+  // where it joined the previous preferred path
+  int access(int x) {
+    int last = n;
+    for(int y = x; y != n; y = par[y]) {
+      splay(y);
+      right[y] = last;
+      pull(y);
+      last = y;
+    }
+    splay(x);
+    return last;
+  }
+
+  void makeRoot(int x) { access(x); flip(x); }
+
+  int findRoot(int x) {
+    access(x);
+    while(true) {
+      push(x);
+      if(left[x] == n) break;
+      x = left[x];
+    }
+    splay(x);
+    return x;
+  }
+
+  bool link(int u, int v) {
+    makeRoot(u);
+    if(findRoot(v) == u) return false;
+    par[u] = v;
+    return true;
+  }
+
+  bool cut(int u, int v) {
+    makeRoot(u);
+    access(v);
+    if(left[v] != u || right[u] != n) return false;
+    left[v] = par[u] = n;
+    pull(v);
+    return true;
+  }
+
+  bool connected(int u, int v) {
+    return u == v || findRoot(u) == findRoot(v);
+  }
+
+  Node pathAggregate(int u, int v) {
+    makeRoot(u);
+    access(v);
+    return sum[v];
+  }
+
+  int lca(int root, int u, int v) {
+    makeRoot(root);
+    access(u);
+    return access(v);
+  }
+
+  void set(int u, Node node) {
+    access(u);
+    val[u] = node;
+    pull(u);
+  }
+};
+
+// -----------------------------------------------
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+struct Sum {
+  long long total;
+  Sum(long long _total = 0): total(_total) {}
+  Sum join(Sum& o) { return Sum(total + o.total); }
+};
+
+// iterative union-find, as in union-find.cpp
+struct UnionFind {
+  vector<int> pset;
+
+  UnionFind(int n) : pset(n, -1) {}
+
+  int get(int i) {
+    while(pset[i] >= 0) {
+      int p = pset[i];
+      if(pset[p] < 0) return p;
+      i = pset[i] = pset[p];
+    }
+    return i;
+  }
+
+  void join(int i, int j) {
+    int xRoot = get(i);
+    int yRoot = get(j);
+    if (xRoot == yRoot) return;
+    if (pset[xRoot] > pset[yRoot]) swap(xRoot, yRoot);
+    pset[xRoot] += pset[yRoot];
+    pset[yRoot] = xRoot;
+  }
+};
+
+double elapsed(chrono::steady_clock::time_point st) {
+  return chrono::duration<double>(chrono::steady_clock::now() - st).count();
+}
+
+int main() {
+  // 0 -- 1 -- 3, 0 -- 2, 1 -- 4
+  LinkCutTree<Sum> lct(5);
+  for(int i = 0; i < 5; i++) lct.set(i, Sum(1 << i));
+  lct.link(1, 0); lct.link(2, 0); lct.link(3, 1); lct.link(4, 1);
+
+  assert(lct.pathAggregate(3, 2).total == 8 + 2 + 1 + 4);
+  assert(lct.lca(0, 3, 4) == 1);
+  assert(lct.lca(0, 3, 2) == 0);
+  assert(lct.lca(4, 3, 2) == 1);
+  assert(!lct.link(3, 2));
+  assert(lct.cut(1, 0));
+  assert(!lct.cut(1, 0));
+  assert(!lct.connected(3, 2) && lct.connected(3, 4));
+
+  // random links and cuts, checked against rebuilding a union-find from the
+  // remaining edges after every cut
+  int n = 20000, ops = 60000;
+  vector<int> kind(ops), us(ops), vs(ops);
+  for(int i = 0; i < ops; i++) {
+    kind[i] = rand() % 3; us[i] = rand() % n; vs[i] = rand() % n;
+  }
+
+  chrono::steady_clock::time_point st = chrono::steady_clock::now();
+  LinkCutTree<Sum> forest(n);
+  vector<pair<int, int>> edges;
+  vector<bool> lctRes;
+  for(int i = 0; i < ops; i++) {
+    int u = us[i], v = vs[i];
+    if(kind[i] == 0 && forest.link(u, v)) edges.push_back(make_pair(u, v));
+    else if(kind[i] == 1 && !edges.empty()) {
+      int e = rand() % edges.size();
+      forest.cut(edges[e].first, edges[e].second);
+      edges[e] = edges.back(); edges.pop_back();
+      kind[i] = -1 - e;  // remember which edge was cut for the replay
+    }
+    else if(kind[i] == 2) lctRes.push_back(forest.connected(u, v));
+  }
+  double lctTime = elapsed(st);
+
+  st = chrono::steady_clock::now();
+  UnionFind uf(n);
+  edges.clear();
+  vector<bool> ufRes;
+  for(int i = 0; i < ops; i++) {
+    int u = us[i], v = vs[i];
+    if(kind[i] == 0 && uf.get(u) != uf.get(v)) {
+      uf.join(u, v);
+      edges.push_back(make_pair(u, v));
+    } else if(kind[i] < 0) {
+      int e = -1 - kind[i];
+      edges[e] = edges.back(); edges.pop_back();
+      uf = UnionFind(n);
+      for(auto& ed : edges) uf.join(ed.first, ed.second);
+    }
+    else if(kind[i] == 2) ufRes.push_back(uf.get(u) == uf.get(v));
+  }
+  double ufTime = elapsed(st);
+
+  assert(lctRes == ufRes);
+  printf("Link-cut tree: %.3lfs, rebuilding union-find: %.3lfs\n", lctTime,
+         ufTime);
+  return 0;
+}
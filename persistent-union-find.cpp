@@ -0,0 +1,146 @@
+/**
+ * Persistent Union-Find structure
+ *
+ * Union-find structure that keeps every past version available, so that
+ * queries can be made against the state after any number of joins.
+ *
+ * Parents and ranks are stored in a persistent array: a segment tree over the
+ * elements where an update copies only the path from the root to the changed
+ * leaf, sharing everything else with the previous version. All nodes live in a
+ * single arena and refer to each other by index. Subsets are merged by rank and
+ * paths are never compressed, as that would need new versions on every query,
+ * so trees have depth O(log(n)).
+ *
+ * Parameters:
+ *   None.
+ *
+ * Operations:
+ *   - `init(int n)` creates version 0 with `n` elements, where each one
+ *     belongs to its own subset;
+ *   - `get(int ver, int i)` returns the subset of element `i` in version `ver`;
+ *   - `join(int ver, int i, int j)` creates a new version from `ver` where the
+ *     subsets of `i` and `j` are merged, returning its number;
+ *   - `sameSet(int ver, int i, int j)` returns if `i` and `j` belong to the
+ *     same subset in version `ver`.
+ *
+ * Complexity:
+ *   - Space: O(n + v * log(n)), with `v` the number of versions;
+ *   - Time:
+ *       * `init`: O(n);
+ *       * `get`: O(log^2(n));
+ *       * `join`: O(log^2(n)), with O(log(n)) new nodes;
+ *       * `sameSet`: O(log^2(n)).
+ */
+
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+struct PersistentUnionFind {
+  struct Node { int left, right, parent, rank; };
+  int n;
+  vector<Node> arena;
+  vector<int> roots;  // root node of each version
+
+  PersistentUnionFind() {}
+  PersistentUnionFind(int n) {
+    init(n);
+  }
+
+  int build(int st, int end) {
+    int node = arena.size();
+    arena.push_back(Node{-1, -1, st, 0});
+    if (st == end) return node;
+    int l = build(st, (st + end) / 2);
+    int r = build((st + end) / 2 + 1, end);
+    arena[node].left = l; arena[node].right = r;
+    return node;
+  }
+
+  // returns the leaf of element `i`
+  const Node& leaf(int node, int i) {
+    int st = 0, end = n - 1;
+    while(st != end) {
+      int mid = (st + end) / 2;
+      if(i <= mid) { node = arena[node].left; end = mid; }
+      else { node = arena[node].right; st = mid + 1; }
+    }
+    return arena[node];
+  }
+
+  // returns a copy of the tree under `node` with the leaf of `i` replaced
+  int update(int node, int st, int end, int i, int parent, int rank) {
+    int copy = arena.size();
+    arena.push_back(arena[node]);
+    if (st == end) {
+      arena[copy].parent = parent; arena[copy].rank = rank;
+      return copy;
+    }
+    int mid = (st + end) / 2;
+    if(i <= mid) {
+      int l = update(arena[node].left, st, mid, i, parent, rank);
+      arena[copy].left = l;
+    } else {
+      int r = update(arena[node].right, mid + 1, end, i, parent, rank);
+      arena[copy].right = r;
+    }
+    return copy;
+  }
+
+  void init(int n) {
+    this->n = n;
+    arena.clear(); roots.clear();
+    arena.reserve(2 * n);
+    if(n > 0) roots.push_back(build(0, n - 1));
+  }
+
+  int get(int ver, int i) {
+    while(true) {
+      int p = leaf(roots[ver], i).parent;
+      if(p == i) return i;
+      i = p;
+    }
+  }
+
+  int join(int ver, int i, int j) {
+    int xRoot = get(ver, i);
+    int yRoot = get(ver, j);
+    int root = roots[ver];
+    if (xRoot != yRoot) {
+      int xRank = leaf(root, xRoot).rank, yRank = leaf(root, yRoot).rank;
+      if (xRank < yRank) { swap(xRoot, yRoot); swap(xRank, yRank); }
+      root = update(root, 0, n - 1, yRoot, xRoot, yRank);
+      if (xRank == yRank)
+        root = update(root, 0, n - 1, xRoot, xRoot, xRank + 1);
+    }
+    roots.push_back(root);
+    return roots.size() - 1;
+  }
+
+  bool sameSet(int ver, int i, int j) {
+    return get(ver, i) == get(ver, j);
+  }
+};
+
+// -----------------------------------------------
+
+#include <cassert>
+
+int main() {
+  PersistentUnionFind uf(5);
+
+  int v1 = uf.join(0, 3, 4);
+  int v2 = uf.join(v1, 1, 4);
+  int v3 = uf.join(0, 0, 1);  // branch off the initial version
+  int v4 = uf.join(v2, 3, 1);
+
+  assert(!uf.sameSet(0, 3, 4));
+  assert(uf.sameSet(v1, 3, 4) && !uf.sameSet(v1, 1, 3));
+  assert(uf.sameSet(v2, 1, 3));
+  assert(uf.sameSet(v3, 0, 1) && !uf.sameSet(v3, 3, 4));
+  assert(uf.sameSet(v4, 1, 3) && !uf.sameSet(v4, 0, 1));
+  assert(v4 == 4);
+
+  return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * Rabin-Karp algorithm
+ *
+ * Searches for occurrences of many patterns of the same length within `str`,
+ * computing a rolling hash of each window of the string and looking it up in
+ * an open addressing table with the hashes of the patterns. Candidates are then
+ * compared character by character, so hash collisions never produce wrong
+ * results. Hashes are polynomials modulo the prime 2^61 - 1.
+ *
+ * The parallel variant splits `str` into one chunk per thread, like the one in
+ * KMP: each thread only reports the windows starting inside its chunk.
+ *
+ * Parameters:
+ *   - `patterns`: the patterns to find, all with the same length;
+ *   - `str`: the string to search;
+ *   - `f`: a callback receiving the starting index of each match and the index
+ *     of the pattern matched. In the parallel variant it is called
+ *     concurrently from several threads and in no particular order;
+ *   - `res`: the vector to be filled with the results;
+ *   - `threads` (parallel only): the number of threads to use.
+ *
+ * Operations:
+ *   - `build(patterns)` builds the table for the given patterns, returning
+ *     `false` and matching nothing if their lengths differ;
+ *   - `forEach(str, f)` calls `f` for every match in `str`;
+ *   - `search(str, res)` fills `res` with (index, pattern) pairs for every
+ *     match in `str`, sorted by index;
+ *   - `parallelForEach(str, f, threads)` and `parallelSearch(str, res,
+ *     threads)` do the same using several threads.
+ *
+ * Complexity:
+ *   - Space: O(k * m), with `k` the number of patterns and `m` their length;
+ *   - Time:
+ *       * `build`: O(k * m);
+ *       * `forEach`, `search`: O(n + c * m) expected, with `n == str.length()`
+ *         and `c` the number of windows whose hash matches some pattern.
+ */
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define HMOD ((1ULL << 61) - 1)
+#define HBASE 1000003
+
+using namespace std;
+
+typedef long long ll;
+typedef unsigned long long ull;
+
+inline ull hmul(ull a, ull b) {
+  __uint128_t c = (__uint128_t) a * b;
+  ull r = (ull) (c & HMOD) + (ull) (c >> 61);
+  return r >= HMOD ? r - HMOD : r;
+}
+inline ull hadd(ull a, ull b) { return a + b >= HMOD ? a + b - HMOD : a + b; }
+inline ull hsub(ull a, ull b) { return a >= b ? a - b : a + HMOD - b; }
+
+// splits [0, n) into `threads` consecutive chunks and calls `f(t, st, end)`
+// for the `t`-th chunk [st, end) in its own thread, waiting for all of them.
+// Less than one thread means one
+template<class F> void forEachChunk(ll n, int threads, F f) {
+  threads = max(1, threads);
+  ll chunk = (n + threads - 1) / threads;
+  vector<thread> pool;
+  for(int t = 0; t < threads; t++) {
+    ll st = min(n, t * chunk);
+    ll end = min(n, st + chunk);
+    pool.push_back(thread([&, t, st, end]() { f(t, st, end); }));
+  }
+  for(thread& th : pool) th.join();
+}
+
+struct RabinKarp {
+  int m;
+  string pats;                        // all patterns, concatenated
+  vector<pair<ull, int>> table;       // (hash, pattern), -1 if empty
+  ull mask, top;                      // `top` is HBASE^(m - 1)
+
+  RabinKarp() {}
+  RabinKarp(const vector<string>& patterns) { build(patterns); }
+
+  ull hash(const char* s) {
+    ull h = 0;
+    for(int i = 0; i < m; i++) h = hadd(hmul(h, HBASE), (unsigned char) s[i]);
+    return h;
+  }
+
+  bool build(const vector<string>& patterns) {
+    m = patterns.empty() ? 0 : patterns[0].size();
+    pats.clear();
+    for(const string& p : patterns) {
+      if(p.size() != patterns[0].size()) {
+        m = 0; pats.clear(); table.assign(1, make_pair(0, -1)); mask = 0;
+        return false;
+      }
+      pats += p;
+    }
+
+    top = 1;
+    for(int i = 1; i < m; i++) top = hmul(top, HBASE);
+
+    size_t size = 1;
+    while(size < 2 * patterns.size()) size *= 2;
+    table.assign(size, make_pair(0, -1));
+    mask = size - 1;
+    for(int p = 0; p < (int) patterns.size(); p++) {
+      ull h = hash(&pats[(size_t) p * m]);
+      ull slot = h & mask;
+      while(table[slot].second >= 0) slot = (slot + 1) & mask;
+      table[slot] = make_pair(h, p);
+    }
+    return true;
+  }
+
+  // reports the matches starting in [st, end)
+  template<class F> void scan(const string& str, ll st, ll end, F f) {
+    if(m == 0 || str.size() < (size_t) m) return;
+    end = min(end, (ll) str.size() - m + 1);
+    if(st >= end) return;
+
+    const char* s = str.data();
+    ull h = hash(s + st);
+    for(ll i = st; ; i++) {
+      for(ull slot = h & mask; table[slot].second >= 0;
+          slot = (slot + 1) & mask) {
+        int p = table[slot].second;
+        const char* pat = &pats[(size_t) p * m];
+        if(table[slot].first == h && equal(s + i, s + i + m, pat)) f(i, p);
+      }
+      if(i + 1 == end) break;
+      h = hsub(h, hmul(top, (unsigned char) s[i]));
+      h = hadd(hmul(h, HBASE), (unsigned char) s[i + m]);
+    }
+  }
+
+  template<class F> void forEach(const string& str, F f) {
+    scan(str, 0, str.size(), f);
+  }
+
+  void search(const string& str, vector<pair<ll, int>>& res) {
+    res.clear();
+    forEach(str, [&](ll idx, int p) { res.push_back(make_pair(idx, p)); });
+  }
+
+  static int defaultThreads() {
+    return max(1, (int) thread::hardware_concurrency());
+  }
+
+  template<class F> void parallelForEach(const string& str, F f,
+                                         int threads = defaultThreads()) {
+    forEachChunk(str.size(), threads, [&](int t, ll st, ll end) {
+      scan(str, st, end, f);
+    });
+  }
+
+  void parallelSearch(const string& str, vector<pair<ll, int>>& res,
+                      int threads = defaultThreads()) {
+    threads = max(1, threads);
+    vector<vector<pair<ll, int>>> part(threads);
+    forEachChunk(str.size(), threads, [&](int t, ll st, ll end) {
+      scan(str, st, end, [&](ll idx, int p) {
+        part[t].push_back(make_pair(idx, p));
+      });
+    });
+
+    res.clear();
+    for(auto& p : part) res.insert(res.end(), p.begin(), p.end());
+  }
+};
+
+// -----------------------------------------------
+
+#include <iostream>
+
+int main() {
+  RabinKarp rk({"AAB", "ACA", "ABA", "AAB"});
+
+  vector<pair<ll, int>> res;
+  rk.search("AABAACAADAABAAABAA", res);
+
+  cout << "Expected: (0,0) (0,3) (1,2) (4,1) (9,0) (9,3) (10,2) (13,0) (13,3) "
+       << "(14,2)" << endl;
+  cout << "  Result: ";
+  for(auto& m : res) cout << "(" << m.first << "," << m.second << ") ";
+  cout << endl;
+
+  string text;
+  unsigned seed = 1;
+  for(int i = 0; i < 1000000; i++) {
+    seed = seed * 1103515245 + 12345;
+    text += "ACGT"[(seed >> 16) & 3];
+  }
+  vector<string> kmers;
+  for(int i = 0; i < 1000; i++) kmers.push_back(text.substr(i * 997, 12));
+  rk.build(kmers);
+
+  vector<pair<ll, int>> parRes;
+  rk.search(text, res);
+  rk.parallelSearch(text, parRes, 7);
+  cout << "Matches: " << res.size() << " (expected at least 1000)" << endl;
+  cout << "Parallel matches equal: " << (res == parRes) << " (expected 1)"
+       << endl;
+
+  cout << "Built with mixed lengths: " << rk.build({"AAB", "AB"})
+       << " (expected 0)" << endl;
+  rk.search("AABAAB", res);
+  cout << "Matches: " << res.size() << " (expected 0)" << endl;
+  return 0;
+}
@@ -6,6 +6,15 @@
  * found at
  * http://apps.topcoder.com/forums/?module=Thread&threadID=696596&start=0.
  *
+ * `parallelTempering` runs one chain per thread instead, each one with its own
+ * copy of the solution and at a different point of a temperature ladder that
+ * spans from the current temperature to `mint`. Periodically, neighbouring
+ * chains in the ladder exchange temperatures with the Metropolis criterion for
+ * replica exchange, so that good solutions found by hot chains get refined by
+ * cold ones. Mutations are created, evaluated and applied concurrently in
+ * different threads, so `Mut` must not modify shared state (including the
+ * state of `rand()`).
+ *
  * Parameters:
  *   - `Sol` (type): a class representing a solution. Must implement a
  *                   `ScoreType getScore()` method;
@@ -13,7 +22,28 @@
  *       * `void init(Sol& sol)`, initializing a valid mutation for `sol`;
  *       * `ScoreType getScore()`, returning the score increase from the current
  *         solution to the mutated one (score of the mutation - original score);
- *       * `void apply(Sol& sol)`, applying the mutation to `sol`.
+ *       * `void apply(Sol& sol)`, applying the mutation to `sol`;
+ *       * Optionally, `void undo(Sol& sol)`, reverting the mutation after it
+ *         was applied to `sol`, in which case `apply` must also work again
+ *         after `undo`. The best solution is then tracked by keeping a log of
+ *         the mutations accepted since it was found, instead of copying it on
+ *         every improvement. Mutations must be copyable;
+ *       * Optionally, `static const int BATCH`, declaring that up to `BATCH`
+ *         mutations can be initialized and scored against the same solution
+ *         independently. Each iteration then creates and scores `BATCH`
+ *         mutations in a row, which lets the compiler interleave their memory
+ *         accesses, and applies the first one accepted;
+ *   - `Schedule` (type): the cooling schedule, mapping the part of the time
+ *     passed to a temperature going from `maxt` to `mint`. Can be
+ *     `ExponentialCooling` (the default), `LinearCooling`,
+ *     `LogarithmicCooling` or `LundyMeesCooling`, or `Reheating<S>` to raise
+ *     the temperature of schedule `S` when the best solution stops improving.
+ *     None of them calls transcendental functions after being built. Custom
+ *     schedules must implement a constructor from `maxt` and `mint`,
+ *     `double temperature(double p)`, `void improved(double p)`, called
+ *     when a new best solution is found, and `void moved(double p)`, called
+ *     when `parallelTempering` moves the chain to another level of the
+ *     ladder, after which `p` may jump backwards or forwards;
  *   - `solution`: the initial solution for the process to consider. Can be a
  *     random valid solution or a solution generated by a fast heuristic;
  *   - `maxt`: the initial (maximal) temperature. It should be large enough to
@@ -22,100 +52,539 @@
  *   - `mint`: the terminal (minimal) temperature. Should be less than the
  *     minimal possible mutation delta or less than the precision wanted;
  *   - `finishAtTime`: the time limit for the whole program to run, including
- *     initialization code.
+ *     initialization code;
+ *   - `replicas`: the number of chains run by `parallelTempering`, by default
+ *     one per hardware thread. Chains run against the clock, so there should
+ *     not be more of them than available cores;
+ *   - `telemetry`: if not NULL, where each chain records its acceptance rate,
+ *     temperature, current and best scores and iterations per second once
+ *     per time slice. `Telemetry` keeps the samples in a ring buffer per
+ *     chain until `flush` writes them as CSV or JSON lines, either at the end
+ *     or periodically from a background thread started with `flushEvery`,
+ *     along with the number of samples dropped because a buffer was full.
  *
  * Returns:
  *   - `solution` is set to the solution with minimum score found.
  *
  * Complexity:
  *   Each iteration is bounded by the time it takes to initialize, calculate the
- *   score and apply a mutation to a solution.
+ *   score and apply a mutation to a solution. `parallelTempering` copies the
+ *   solution once per replica. When mutations can be undone, the best solution
+ *   is copied at most once every 2^16 accepted mutations.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
-#include <sys/time.h>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define REHEAT_AFTER 0.05
+#define REHEAT_FACTOR 4.0
+#define REHEAT_SPAN 0.02
 
 using namespace std;
 
+typedef long long ll;
+typedef unsigned long long ull;
+
+// monotonic clock, read through the vDSO without a system call. The coarse
+// clock would be cheaper still, but only ticks every few milliseconds
 double getTime() {
-  timeval tv; gettimeofday(&tv, NULL);
-  return double (tv.tv_sec) + 0.000001 * tv.tv_usec;
+  timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+  return double (ts.tv_sec) + 1e-9 * ts.tv_nsec;
 }
 
 double globalStartTime = getTime();
 
-template<class Sol, class Mut> void simulatedAnnealing(
-    Sol& solution, double maxt, double mint, double finishAtTime) {
+// returns a uniform number in [0, 1), advancing the xorshift state `seed`
+inline double nextUniform(ull& seed) {
+  seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+  return (seed >> 11) * (1.0 / (1ULL << 53));
+}
+
+// natural logarithm of a positive normal `x`, with an absolute error below
+// 2e-5. `log(m)` for the mantissa `m` in [1, 2) is expanded as
+// 2 * atanh((m - 1) / (m + 1))
+inline double fastLog(double x) {
+  ull bits; memcpy(&bits, &x, sizeof(x));
+  int e = (int) (bits >> 52) - 1023;
+  bits = (bits & ((1ULL << 52) - 1)) | (1023ULL << 52);
+  double m; memcpy(&m, &bits, sizeof(m));
+  double t = (m - 1) / (m + 1), t2 = t * t;
+  return e * M_LN2 +
+      2 * t * (1 + t2 * (1.0 / 3 + t2 * (1.0 / 5 + t2 * (1.0 / 7))));
+}
+
+// checks if `Mut` implements `undo`
+template<class Mut> struct Undoable {
+  template<class M> static char test(decltype(&M::undo));
+  template<class M> static long test(...);
+  static const bool value = sizeof(test<Mut>(0)) == 1;
+};
+
+// returns `Mut::BATCH` if defined, or 1
+template<class Mut> struct BatchSize {
+  template<class M> static constexpr int get(decltype(M::BATCH)*) {
+    return M::BATCH;
+  }
+  template<class M> static constexpr int get(...) { return 1; }
+  static const int value = get<Mut>(0);
+};
+
+template<class Sol, class Mut, bool undoable = Undoable<Mut>::value>
+struct BestTracker;
+
+// keeps a copy of the best solution
+template<class Sol, class Mut> struct BestTracker<Sol, Mut, false> {
+  Sol best;
+  double score;
+
+  BestTracker(Sol& sol): best(sol), score(sol.getScore()) {}
+
+  // to be called after `mut` is applied to `sol`, returning if `sol` is the
+  // new best solution
+  bool accepted(Sol& sol, Mut& mut) {
+    if (sol.getScore() >= score) return false;
+    best = sol; score = sol.getScore();
+    return true;
+  }
+
+  // sets `sol` to the best solution
+  void restore(Sol& sol) { sol = best; }
+};
+
+// keeps the mutations accepted since the best solution was found, so that it
+// can be reached by undoing them. When there are too many of them, the best
+// solution is copied to `snapshot` and the log is dropped
+template<class Sol, class Mut> struct BestTracker<Sol, Mut, true> {
+  static const size_t MAX_LOG = 1 << 16;
+  vector<Mut> log;
+  vector<Sol> snapshot;
+  bool logging;
+  double score;
+
+  BestTracker(Sol& sol): logging(true), score(sol.getScore()) {}
+
+  void undoLog(Sol& sol) {
+    for(size_t i = log.size(); i > 0; i--) log[i - 1].undo(sol);
+  }
+
+  bool accepted(Sol& sol, Mut& mut) {
+    if (sol.getScore() < score) {
+      score = sol.getScore();
+      log.clear(); logging = true;
+      return true;
+    }
+    if (logging) {
+      log.push_back(mut);
+      if (log.size() >= MAX_LOG) {
+        undoLog(sol);
+        snapshot.assign(1, sol);
+        for(Mut& m : log) m.apply(sol);
+        log.clear(); logging = false;
+      }
+    }
+    return false;
+  }
+
+  void restore(Sol& sol) {
+    if (logging) { undoLog(sol); log.clear(); }
+    else sol = snapshot[0];
+  }
+};
+
+// cooling schedules, giving the temperature after a part `p` of the schedule
+
+// interpolates a schedule from its inverse temperature at STEPS + 1 points,
+// which is close to linear for fast decreasing schedules
+struct TabulatedCooling {
+  static const int STEPS = 1024;
+  double inv[STEPS + 1];
+
+  double temperature(double p) {
+    double x = min(p, 1.0) * STEPS;
+    int i = min((int) x, STEPS - 1);
+    return 1 / (inv[i] + (inv[i + 1] - inv[i]) * (x - i));
+  }
+
+  void improved(double p) {}
+  void moved(double p) {}
+};
+
+struct ExponentialCooling : TabulatedCooling {
+  ExponentialCooling(double maxt, double mint) {
+    for(int i = 0; i <= STEPS; i++)
+      inv[i] = 1 / (maxt * pow(mint / maxt, (double) i / STEPS));
+  }
+};
+
+struct LogarithmicCooling : TabulatedCooling {
+  LogarithmicCooling(double maxt, double mint) {
+    for(int i = 0; i <= STEPS; i++) {
+      double p = (double) i / STEPS;
+      inv[i] = (1 + (maxt / mint - 1) * log(1 + (M_E - 1) * p)) / maxt;
+    }
+  }
+};
+
+struct LinearCooling {
+  double maxt, mint;
+  LinearCooling(double maxt, double mint): maxt(maxt), mint(mint) {}
+  double temperature(double p) { return maxt + (mint - maxt) * p; }
+  void improved(double p) {}
+  void moved(double p) {}
+};
+
+// Lundy-Mees, T' = T / (1 + b * T) once per step, with `b` chosen so that the
+// temperature reaches `mint` at the end
+struct LundyMeesCooling {
+  double maxt, mint;
+  LundyMeesCooling(double maxt, double mint): maxt(maxt), mint(mint) {}
+  double temperature(double p) {
+    return maxt * mint / (mint + (maxt - mint) * p);
+  }
+  void improved(double p) {}
+  void moved(double p) {}
+};
+
+// multiplies the temperature of `S` by REHEAT_FACTOR when the best solution
+// has not improved for REHEAT_AFTER of the schedule, decaying back to `S`
+// during REHEAT_SPAN. Stagnation is measured from the level the chain is at,
+// so it starts over when the chain moves in the ladder
+template<class S> struct Reheating {
+  S base;
+  double lastImproved, reheatedAt;
+
+  Reheating(double maxt, double mint):
+      base(maxt, mint), lastImproved(0), reheatedAt(-1) {}
+
+  double temperature(double p) {
+    if (p - max(lastImproved, reheatedAt) > REHEAT_AFTER) reheatedAt = p;
+    double left = min(max(1 - (p - reheatedAt) / REHEAT_SPAN, 0.0), 1.0);
+    return base.temperature(p) * (1 + (REHEAT_FACTOR - 1) * left);
+  }
+
+  void improved(double p) { lastImproved = p; }
+  void moved(double p) { lastImproved = p; reheatedAt = -1; }
+};
+
+// progress of a chain during a time slice
+struct Sample {
+  int chain;
+  double time, temp, accRate, itersPerSec, score, best;
+};
+
+// keeps the samples of each chain in a preallocated ring buffer, written only
+// by that chain, until they are flushed. Samples are dropped if the buffer is
+// full, and the number of them is reported by the next flush
+struct Telemetry {
+  struct Ring {
+    vector<Sample> buf;
+    atomic<ll> head, tail;  // samples recorded and flushed
+  };
+  double slice;
+  bool json, header;
+  vector<Ring> rings;
+  // samples dropped, in total and up to the last flush
+  atomic<ll> dropped;
+  ll reported;
+
+  mutex mtx;
+  condition_variable cv;
+  thread flusher;
+  bool stopping;
+
+  // `slice` is the time between samples of a chain, in seconds
+  Telemetry(int chains, double slice = 0.1, int capacity = 1024,
+            bool json = false):
+      slice(slice), json(json), header(false), rings(chains), dropped(0),
+      reported(0), stopping(false) {
+    for(Ring& r : rings) { r.buf.resize(capacity); r.head = r.tail = 0; }
+  }
+
+  ~Telemetry() { stop(); }
+
+  void record(const Sample& s) {
+    if (s.chain >= (int) rings.size()) return;
+    Ring& r = rings[s.chain];
+    ll h = r.head.load(memory_order_relaxed);
+    if (h - r.tail.load(memory_order_acquire) == (ll) r.buf.size()) {
+      dropped++; return;
+    }
+    r.buf[h % r.buf.size()] = s;
+    r.head.store(h + 1, memory_order_release);
+  }
+
+  // writes the pending samples to `f`, as CSV or JSON lines
+  void flush(FILE* f) {
+    lock_guard<mutex> lock(mtx);
+    if (!json && !header) {
+      fprintf(f, "chain,time,temp,acc_rate,iters_per_sec,score,best\n");
+      header = true;
+    }
+    for(Ring& r : rings) {
+      ll h = r.head.load(memory_order_acquire);
+      for(ll t = r.tail.load(memory_order_relaxed); t < h; t++) {
+        const Sample& s = r.buf[t % r.buf.size()];
+        fprintf(f, json ? "{\"chain\":%d,\"time\":%.6lf,\"temp\":%.6lg,"
+                "\"acc_rate\":%.6lf,\"iters_per_sec\":%.0lf,\"score\":%.6lg,"
+                "\"best\":%.6lg}\n" : "%d,%.6lf,%.6lg,%.6lf,%.0lf,%.6lg,%.6lg\n",
+                s.chain, s.time, s.temp, s.accRate, s.itersPerSec, s.score,
+                s.best);
+      }
+      r.tail.store(h, memory_order_release);
+    }
+    ll d = dropped.load();
+    if (d > reported) {
+      fprintf(f, json ? "{\"dropped\":%lld}\n" : "# dropped %lld samples\n",
+              d - reported);
+      reported = d;
+    }
+    fflush(f);
+  }
+
+  // flushes to `f` every `interval` seconds from a background thread, until
+  // `stop` is called
+  void flushEvery(FILE* f, double interval) {
+    stop();
+    stopping = false;
+    flusher = thread([=]() {
+      unique_lock<mutex> lock(mtx);
+      while(!stopping) {
+        cv.wait_for(lock, chrono::duration<double>(interval));
+        lock.unlock(); flush(f); lock.lock();
+      }
+    });
+  }
+
+  void stop() {
+    if (!flusher.joinable()) return;
+    { lock_guard<mutex> lock(mtx); stopping = true; }
+    cv.notify_all();
+    flusher.join();
+  }
+};
+
+// state of a single annealing chain
+template<class Sol, class Mut, class Schedule> struct Chain {
+  Sol solution;
+  BestTracker<Sol, Mut> best;
+  Schedule schedule;
+  // offset of the chain in the temperature ladder, in [0, 1). A chain at level
+  // `l` uses the temperature the schedule has after `done + (1 - done) * l`
+  double level;
+  ull seed;
+  ll iters, accMuts;
+  // iterations between syncs, adapted to the cost of an iteration
+  int syncEvery;
+  // where to record samples to, if anywhere, and the start of the current
+  // time slice
+  Telemetry* telemetry;
+  int id;
+  double sliceStart;
+  ll sliceIters, sliceAccMuts;
+
+  Chain(const Sol& sol, double maxt, double mint, double level, ull seed,
+        Telemetry* telemetry, int id):
+      solution(sol), best(solution), schedule(maxt, mint), level(level),
+      seed(seed), iters(0), accMuts(0), syncEvery(1), telemetry(telemetry),
+      id(id), sliceStart(getTime()), sliceIters(0), sliceAccMuts(0) {}
+
+  double progress(double done) { return done + (1.0 - done) * level; }
+
+  double temperature(double done) {
+    return schedule.temperature(progress(done));
+  }
+
+  void record(double now, double time, double temp) {
+    ll n = iters - sliceIters;
+    Sample s = {id, time, temp, n ? (double) (accMuts - sliceAccMuts) / n : 0,
+                n / (now - sliceStart), solution.getScore(), best.score};
+    telemetry->record(s);
+    sliceStart = now; sliceIters = iters; sliceAccMuts = accMuts;
+  }
+};
 
-  // sync means calculating current temperature from current work time
-  static const int ITERS_PER_SYNC = 16;       // must be power of two
-  // sometimes we dump current progress to stderr
-  static const int ITERS_PER_DUMP = 0x40000;  // must be power of two
+// runs `chain` until the part of the schedule passed reaches `untilDone`,
+// returning false if the time is over
+template<class Sol, class Mut, class Schedule> bool annealChain(
+    Chain<Sol, Mut, Schedule>& chain, double startTime, double hasTime,
+    double untilDone) {
+
+  // the first time slice starts with the annealing, not with the chain
+  if (chain.iters == 0) chain.sliceStart = getTime();
+
+  // sync means calculating current temperature from current work time, which
+  // is done about every SYNC_INTERVAL seconds
+  static const double SYNC_INTERVAL = 50e-6;
+  static const int MAX_ITERS_PER_SYNC = 1 << 20;
+  // number of mutations evaluated together
+  static const int BATCH = BatchSize<Mut>::value;
   // type of solution score
   typedef double ScoreType;
 
-  // number of iterations done so far
-  int iters = 0;
+  Sol& solution = chain.solution;
   // part of the full cooling schedule passed
-  double done = 0.0;
-  // best solution so far
-  Sol best = solution;
-  // number of accepted mutations overall
-  int accMuts = 0;
-
-  // time when the SA begins
-  double startTime = getTime();
-  // time dedicated for SA processing
-  double hasTime = finishAtTime - (startTime - globalStartTime);
+  double done = (getTime() - startTime) / hasTime;
+  // current temperature, which only changes when syncing
+  double temp = chain.temperature(done);
+  // time of the last sync, or negative before the first one, which happens
+  // right away and says nothing about the cost of an iteration
+  double lastSync = -1;
+  int untilSync = 0;
 
   while(true) {
-    // dump stats so that you can watch the progress of SA
-    if (!(iters & (ITERS_PER_DUMP - 1)))
-      fprintf(stderr, "Iteration:%6d  Acc:%6d  Temp:%7.3lf  Score:%0.5lf\n",
-              iters, accMuts, maxt * pow(mint / maxt, done),
-              solution.getScore());
     // synchronize the temperature with time
-    if (!(iters & (ITERS_PER_SYNC - 1))) {
-      done = (getTime() - startTime) / hasTime;
-      if (done >= 1.0) break;
+    if (--untilSync < 0) {
+      double now = getTime();
+      done = (now - startTime) / hasTime;
+      if (done >= 1.0) return false;
+      if (done >= untilDone) return true;
+      temp = chain.temperature(done);
+      // record the progress of the chain once per time slice
+      if (chain.telemetry && now - chain.sliceStart >= chain.telemetry->slice)
+        chain.record(now, now - startTime, temp);
+
+      // aim for the next sync to happen SYNC_INTERVAL from now
+      double elapsed = lastSync < 0 ? SYNC_INTERVAL : now - lastSync;
+      if (elapsed < SYNC_INTERVAL / 2)
+        chain.syncEvery = min(chain.syncEvery * 2, MAX_ITERS_PER_SYNC);
+      else if (elapsed > SYNC_INTERVAL * 2)
+        chain.syncEvery = max(chain.syncEvery / 2, 1);
+      untilSync = chain.syncEvery - 1;
+      lastSync = now;
     }
 
-    // create mutation for current solution
-    Mut mut;
-    mut.init(solution);
-    // get the score delta of the mutation
-    ScoreType delta = mut.getScore();
-
-    //if mutated solution is better, accept it
-    bool move = false;
-    if (delta <= 0) move = true;
-    else {
-      // otherwise calculate current temperature
-      double temp = maxt * pow(mint / maxt, done);
-      // and accept with the tricky probability
-      move = ((double) rand() / (RAND_MAX)) < exp(-delta / temp);
+    // create a batch of mutations for current solution
+    Mut muts[BATCH];
+    for(int b = 0; b < BATCH; b++) muts[b].init(solution);
+    // get the score deltas of the mutations
+    ScoreType deltas[BATCH];
+    for(int b = 0; b < BATCH; b++) deltas[b] = muts[b].getScore();
+
+    // consider the mutations in order, as if they were separate iterations,
+    // until one is accepted. The ones after it are stale and get discarded
+    int b = 0;
+    for(; b < BATCH; b++) {
+      //if mutated solution is better, accept it
+      bool move = false;
+      if (deltas[b] <= 0) move = true;
+      else {
+        // otherwise accept with the tricky probability: u < exp(-delta / temp)
+        // is the same as delta < -temp * log(u), which avoids calling exp
+        move = deltas[b] < -temp * fastLog(nextUniform(chain.seed));
+      }
+
+      // if mutation is accepted, apply it to the solution and do not forget
+      // to store the best solution
+      if (move) {
+        chain.accMuts++;
+        muts[b].apply(solution);
+        if (chain.best.accepted(solution, muts[b]))
+          chain.schedule.improved(chain.progress(done));
+        break;
+      }
     }
+    chain.iters += min(b + 1, BATCH);
+  }
+}
 
-    // if mutation is accepted, apply it to the solution
-    if (move) { accMuts++; mut.apply(solution); }
+template<class Sol, class Mut, class Schedule = ExponentialCooling>
+void simulatedAnnealing(
+    Sol& solution, double maxt, double mint, double finishAtTime,
+    Telemetry* telemetry = NULL) {
 
-    // do not forget to store the best solution
-    if (solution.getScore() < best.getScore()) best = solution;
-    iters++;
-  }
+  Chain<Sol, Mut, Schedule> chain(solution, maxt, mint, 0.0,
+                                  88172645463325252ULL, telemetry, 0);
+
+  // time when the SA begins
+  double startTime = getTime();
+  // time dedicated for SA processing
+  double hasTime = finishAtTime - (startTime - globalStartTime);
+  annealChain(chain, startTime, hasTime, 1.0);
 
   //return the best solution as the result
-  fprintf(stderr, "Simulated annealing made %d iterations (accepted: %d)\n",
-          iters, accMuts);
-  solution = best;
+  fprintf(stderr, "Simulated annealing made %lld iterations (accepted: %lld, "
+          "%.2lf M/s)\n", chain.iters, chain.accMuts,
+          chain.iters / (getTime() - startTime) / 1e6);
+  chain.best.restore(chain.solution);
+  solution = chain.solution;
+}
+
+template<class Sol, class Mut, class Schedule = ExponentialCooling>
+void parallelTempering(
+    Sol& solution, double maxt, double mint, double finishAtTime,
+    int replicas = max(1, (int) thread::hardware_concurrency()),
+    Telemetry* telemetry = NULL) {
+
+  // number of rounds of replica exchanges over the whole schedule
+  static const int SWAP_ROUNDS = 200;
+
+  vector<Chain<Sol, Mut, Schedule>> chains;
+  for(int k = 0; k < replicas; k++)
+    chains.push_back(Chain<Sol, Mut, Schedule>(
+        solution, maxt, mint, (double) k / replicas,
+        0x9E3779B97F4A7C15ULL * (k + 1), telemetry, k));
+  // chains sorted by level, from the hottest to the coldest
+  vector<int> ladder(replicas);
+  for(int k = 0; k < replicas; k++) ladder[k] = k;
+  ull seed = 88172645463325252ULL;
+
+  double startTime = getTime();
+  double hasTime = finishAtTime - (startTime - globalStartTime);
+  for(int round = 1; ; round++) {
+    double untilDone = (double) round / SWAP_ROUNDS;
+    vector<char> running(replicas);
+    vector<thread> pool;
+    for(int k = 0; k < replicas; k++) {
+      pool.push_back(thread([&, k]() {
+        running[k] = annealChain(chains[k], startTime, hasTime, untilDone);
+      }));
+    }
+    for(thread& th : pool) th.join();
+    if (count(running.begin(), running.end(), 0)) break;
+
+    // try to exchange the levels of each pair of neighbouring chains
+    double done = (getTime() - startTime) / hasTime;
+    for(int i = round % 2; i + 1 < replicas; i += 2) {
+      Chain<Sol, Mut, Schedule>& hot = chains[ladder[i]];
+      Chain<Sol, Mut, Schedule>& cold = chains[ladder[i + 1]];
+      double hotTemp = hot.temperature(done);
+      double coldTemp = cold.temperature(done);
+      double e = (hot.solution.getScore() - cold.solution.getScore()) *
+          (1.0 / hotTemp - 1.0 / coldTemp);
+      if (e >= 0 || nextUniform(seed) < exp(e)) {
+        swap(hot.level, cold.level);
+        swap(ladder[i], ladder[i + 1]);
+        hot.schedule.moved(hot.progress(done));
+        cold.schedule.moved(cold.progress(done));
+      }
+    }
+  }
+
+  ll iters = 0, accMuts = 0;
+  int best = 0;
+  for(int k = 0; k < replicas; k++) {
+    iters += chains[k].iters; accMuts += chains[k].accMuts;
+    if (chains[k].best.score < chains[best].best.score) best = k;
+  }
+  fprintf(stderr, "Parallel tempering made %lld iterations in %d replicas "
+          "(accepted: %lld)\n", iters, replicas, accMuts);
+  chains[best].best.restore(chains[best].solution);
+  solution = chains[best].solution;
 }
 
 // -----------------------------------------------
 
-#include <algorithm>
-#include <ctime>
+#include <cassert>
 
 #define N 15
 #define TIMELIMIT 9.8
@@ -150,9 +619,17 @@ struct Sol {
   double getScore() { return total; }
 };
 
+// rand() is shared by all threads, so mutations use a generator per thread
+atomic<ull> streams(0);
+
+inline int randInt(int n) {
+  static thread_local ull seed = ++streams * 0x9E3779B97F4A7C15ULL;
+  return nextUniform(seed) * n;
+}
+
 struct Mut {
   int i, total;
-  Mut() { i = rand() % N; }
+  Mut() { i = randInt(N); }
 
   void init(Sol& sol) {
     total = dist[sol.order[(i + 1) % N]][sol.order[i]] -
@@ -174,8 +651,74 @@ struct Mut {
 
     sol.total += total;
   }
+
+  void undo(Sol& sol) {
+    apply(sol);
+    sol.total -= 2 * total;
+  }
 };
 
+// mutations scored in batches, counting how many were created
+struct BMut : Mut {
+  static const int BATCH = 4;
+  static ll inits;
+
+  void init(Sol& sol) { inits++; Mut::init(sol); }
+};
+
+ll BMut::inits = 0;
+
+// checks that `Schedule` cools from `maxt` to `mint` without ever heating up
+template<class Schedule> void checkCooling(double maxt, double mint) {
+  Schedule schedule(maxt, mint);
+  assert(fabs(schedule.temperature(0) / maxt - 1) < 1e-6);
+  double last = maxt;
+  for(int i = 1; i <= 1000; i++) {
+    double t = schedule.temperature(i / 1000.0);
+    assert(t <= last * (1 + 1e-9));
+    last = t;
+  }
+  assert(fabs(last / mint - 1) < 1e-6);
+}
+
+// checks that `Reheating` only heats up when stagnating, and at most by
+// REHEAT_FACTOR, even when the chain moves back in the ladder
+void checkReheating(double maxt, double mint) {
+  ExponentialCooling base(maxt, mint);
+  Reheating<ExponentialCooling> schedule(maxt, mint);
+  assert(fabs(schedule.temperature(0) / maxt - 1) < 1e-6);
+
+  bool reheated = false;
+  for(int i = 1; i <= 800; i++) {
+    double p = i / 1000.0, t = schedule.temperature(p);
+    assert(t >= base.temperature(p) * (1 - 1e-9));
+    assert(t <= REHEAT_FACTOR * base.temperature(p) * (1 + 1e-9));
+    reheated |= t > base.temperature(p) * (1 + 1e-9);
+  }
+  assert(reheated);
+  assert(schedule.temperature(0.5) <=
+         REHEAT_FACTOR * base.temperature(0.5) * (1 + 1e-9));
+
+  schedule.moved(0.5);
+  assert(fabs(schedule.temperature(0.5) / base.temperature(0.5) - 1) < 1e-9);
+  double p = 0.5 + REHEAT_AFTER * 1.1;
+  assert(fabs(schedule.temperature(p) / base.temperature(p) - REHEAT_FACTOR) <
+         1e-9);
+
+  schedule.improved(1.0);
+  assert(fabs(schedule.temperature(1.0) / mint - 1) < 1e-6);
+}
+
+// runs a short annealing of `sol` with `Schedule`, checking the result
+template<class Schedule> void checkAnnealing(
+    Sol sol, double maxt, double mint, double finishAtTime) {
+  int initial = sol.total;
+  simulatedAnnealing<Sol, Mut, Schedule>(sol, maxt, mint, finishAtTime);
+  int total = sol.total;
+  sol.updateScore();
+  assert(sol.total == total && total <= initial);
+}
+
 int main() {
   srand(time(NULL));
 
@@ -193,8 +736,47 @@ int main() {
 
   double maxt = avgDist * 10.0;
   double mint = avgDist * 0.001;
-  simulatedAnnealing<Sol, Mut>(sol, maxt, mint, TIMELIMIT);
 
-  printf("%d\n", sol.total);
+  checkCooling<ExponentialCooling>(maxt, mint);
+  checkCooling<LinearCooling>(maxt, mint);
+  checkCooling<LogarithmicCooling>(maxt, mint);
+  checkCooling<LundyMeesCooling>(maxt, mint);
+  checkReheating(maxt, mint);
+
+  checkAnnealing<ExponentialCooling>(sol, maxt, mint, 0.1);
+  checkAnnealing<LinearCooling>(sol, maxt, mint, 0.2);
+  checkAnnealing<LogarithmicCooling>(sol, maxt, mint, 0.3);
+  checkAnnealing<LundyMeesCooling>(sol, maxt, mint, 0.4);
+  checkAnnealing<Reheating<ExponentialCooling>>(sol, maxt, mint, 0.5);
+
+  // mutations created after the accepted one in a batch are discarded, and do
+  // not count as iterations
+  Chain<Sol, BMut, ExponentialCooling> batched(sol, maxt, mint, 0.0,
+                                               88172645463325252ULL, NULL, 0);
+  annealChain(batched, getTime(), 0.1, 1.0);
+  assert(batched.accMuts > 0 && batched.accMuts <= batched.iters);
+  assert(BMut::inits >= batched.iters);
+  assert(BMut::inits - batched.iters <=
+         (ll) (BMut::BATCH - 1) * batched.accMuts);
+  batched.best.restore(batched.solution);
+  int total = batched.solution.total;
+  batched.solution.updateScore();
+  assert(batched.solution.total == total && total <= sol.total);
+  Sol tempered = sol;
+
+  // progress is written as CSV to stderr at the end of the single chain, and
+  // as JSON while the replicas run
+  Telemetry saTelemetry(1, 0.5);
+  simulatedAnnealing<Sol, Mut>(sol, maxt, mint, TIMELIMIT / 2, &saTelemetry);
+  saTelemetry.flush(stderr);
+
+  int replicas = max(1, (int) thread::hardware_concurrency());
+  Telemetry ptTelemetry(replicas, 0.5, 1024, true);
+  ptTelemetry.flushEvery(stderr, 1.0);
+  parallelTempering<Sol, Mut>(tempered, maxt, mint, TIMELIMIT, replicas,
+                              &ptTelemetry);
+  ptTelemetry.stop();
+
+  printf("%d %d\n", sol.total, tempered.total);
   return 0;
 }
@@ -0,0 +1,329 @@
+/**
+ * Streaming connectivity
+ *
+ * Finds the connected components of a graph whose edge list is too large to
+ * fit in memory, as long as a union-find structure over its vertices does. The
+ * edge file is read sequentially through a large buffer and parsed by one
+ * thread into batches of edges, which are handed to a second thread that joins
+ * them, so that reading and parsing overlap with the joins. Only a fixed
+ * number of batches exist at any time, bounding memory.
+ *
+ * Edge files can be binary, as consecutive pairs of 32-bit vertex indices, or
+ * text, with two vertex indices per line separated by spaces or tabs. Blank
+ * lines and comments starting with `#` or `%` are ignored. Text lines that are
+ * not a pair of non-negative integers, that are longer than MAX_LINE bytes, or
+ * edges of either format with an index out of [0, n) are skipped and counted
+ * as rejected.
+ *
+ * Parameters:
+ *   - `path`: the edge file to read;
+ *   - `n`: the number of vertices;
+ *   - `binary`: whether the file is binary or text;
+ *   - `uf`: the union-find structure to fill, which must have `n` elements.
+ *
+ * Returns:
+ *   - the function returns a `StreamStats` with the number of edges joined,
+ *     the number of records rejected, the bytes read, the time taken, the number of components and the size of the
+ *     largest one, or with `ok == false` if the file could not be read;
+ *   - `uf` gets the components of the graph.
+ *
+ * Complexity:
+ *   - Space: O(n + BATCHES * BATCH_SIZE + BUFFER_SIZE);
+ *   - Time: O(e * α(n)), with `e` the number of edges.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#define BUFFER_SIZE (16 << 20)
+#define BATCH_SIZE (1 << 20)
+#define BATCHES 4
+// the parser is given at most this many bytes at a time, which keeps a batch
+// from growing past BATCH_SIZE edges
+#define MAX_LINE (BATCH_SIZE * 2)
+
+using namespace std;
+
+typedef long long ll;
+
+// iterative union-find, as in union-find.cpp
+struct UnionFind {
+  vector<int> pset;
+  int sets;
+
+  UnionFind(int n) : pset(n, -1), sets(n) {}
+
+  int get(int i) {
+    while(pset[i] >= 0) {
+      int p = pset[i];
+      if(pset[p] < 0) return p;
+      i = pset[i] = pset[p];
+    }
+    return i;
+  }
+
+  bool join(int i, int j) {
+    int xRoot = get(i);
+    int yRoot = get(j);
+    if (xRoot == yRoot) return false;
+    if (pset[xRoot] > pset[yRoot]) swap(xRoot, yRoot);
+    pset[xRoot] += pset[yRoot];
+    pset[yRoot] = xRoot;
+    sets--;
+    return true;
+  }
+};
+
+typedef vector<pair<int, int>> Batch;
+
+// queue of batches shared by the parser and the union thread
+struct BatchQueue {
+  queue<Batch*> items;
+  mutex mtx;
+  condition_variable cv;
+
+  void push(Batch* b) {
+    { lock_guard<mutex> lock(mtx); items.push(b); }
+    cv.notify_one();
+  }
+
+  Batch* pop() {
+    unique_lock<mutex> lock(mtx);
+    cv.wait(lock, [&]() { return !items.empty(); });
+    Batch* b = items.front(); items.pop();
+    return b;
+  }
+};
+
+struct StreamStats {
+  bool ok;
+  ll edges, rejected, bytes;
+  double seconds;
+  int components, giant;
+};
+
+inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// parses the text line [p, end) into `batch`, returning false if it is neither
+// an edge, a comment nor blank
+bool parseLine(const char* p, const char* end, Batch& batch) {
+  while(p < end && isBlank(*p)) p++;
+  if(p == end || *p == '#' || *p == '%') return true;
+  ll v[2];
+  for(int k = 0; k < 2; k++) {
+    if(p == end || *p < '0' || *p > '9') return false;
+    for(v[k] = 0; p < end && *p >= '0' && *p <= '9'; p++) {
+      v[k] = v[k] * 10 + (*p - '0');
+      if(v[k] > INT_MAX) return false;
+    }
+    if(p < end && !isBlank(*p)) return false;
+    while(p < end && isBlank(*p)) p++;
+  }
+  if(p != end) return false;
+  batch.push_back(make_pair((int) v[0], (int) v[1]));
+  return true;
+}
+
+// parses the complete records in `buf`, returning how many bytes were used and
+// counting the lines that could not be parsed in `rejected`
+size_t parseEdges(const char* buf, size_t len, bool binary, Batch& batch,
+                  ll& rejected) {
+  if(binary) {
+    size_t used = len / 8 * 8;
+    for(size_t i = 0; i < used; i += 8) {
+      int e[2];
+      memcpy(e, buf + i, 8);
+      batch.push_back(make_pair(e[0], e[1]));
+    }
+    return used;
+  }
+
+  size_t used = 0;
+  for(size_t i = 0; i < len; i++) {
+    if(buf[i] != '\n') continue;
+    if(!parseLine(buf + used, buf + i, batch)) rejected++;
+    used = i + 1;
+  }
+  return used;
+}
+
+StreamStats streamComponents(const char* path, int n, bool binary,
+                             UnionFind& uf) {
+  StreamStats stats = {false, 0, 0, 0, 0, 0, 0};
+  int fd = open(path, O_RDONLY);
+  if(fd < 0) return stats;
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  vector<Batch> batches(BATCHES);
+  BatchQueue freeQ, fullQ;
+  for(Batch& b : batches) { b.reserve(BATCH_SIZE); freeQ.push(&b); }
+
+  // edges out of range, counted apart from `stats.rejected`, which the parser
+  // writes concurrently
+  ll outOfRange = 0;
+  thread joiner([&]() {
+    Batch* b;
+    while((b = fullQ.pop()) != NULL) {
+      for(auto& e : *b) {
+        if(e.first >= 0 && e.first < n && e.second >= 0 && e.second < n) {
+          uf.join(e.first, e.second);
+          stats.edges++;
+        } else outOfRange++;
+      }
+      b->clear();
+      freeQ.push(b);
+    }
+  });
+
+  vector<char> buf(BUFFER_SIZE);
+  size_t filled = 0;
+  Batch* b = freeQ.pop();
+  bool eof = false, failed = false, skipping = false;
+  while(!eof) {
+    ssize_t r = read(fd, buf.data() + filled, buf.size() - filled);
+    if(r < 0) {
+      if(errno == EINTR) continue;
+      failed = true;
+      break;
+    }
+    if(r == 0) {
+      eof = true;
+      // a last line without a trailing newline is still an edge
+      if(!binary && filled > 0 && filled < buf.size()) buf[filled++] = '\n';
+    } else {
+      filled += r;
+      stats.bytes += r;
+    }
+
+    size_t pos = 0;
+    while(pos < filled) {
+      if(skipping) {
+        // drop the rest of a line too long to be parsed
+        const char* nl = (const char*) memchr(buf.data() + pos, '\n',
+                                              filled - pos);
+        if(!nl) { pos = filled; break; }
+        pos = nl - buf.data() + 1;
+        skipping = false;
+        continue;
+      }
+      size_t chunk = min(filled - pos, (size_t) MAX_LINE);
+      size_t used = parseEdges(buf.data() + pos, chunk, binary, *b,
+                               stats.rejected);
+      if(used == 0) {
+        if(chunk < MAX_LINE) break;
+        stats.rejected++;
+        skipping = true;
+        continue;
+      }
+      pos += used;
+      if(b->size() >= BATCH_SIZE / 2) { fullQ.push(b); b = freeQ.pop(); }
+    }
+    // keep the incomplete record for the next read, which is shorter than
+    // MAX_LINE and so always fits in the buffer
+    memmove(buf.data(), buf.data() + pos, filled - pos);
+    filled -= pos;
+  }
+  close(fd);
+  fullQ.push(b);
+  fullQ.push(NULL);
+  joiner.join();
+
+  stats.ok = !failed;
+  stats.rejected += outOfRange;
+  stats.seconds = chrono::duration<double>(
+      chrono::steady_clock::now() - start).count();
+  stats.components = uf.sets;
+  for(int i = 0; i < n; i++)
+    if(uf.pset[i] < 0) stats.giant = max(stats.giant, -uf.pset[i]);
+  return stats;
+}
+
+// -----------------------------------------------
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+
+void report(const StreamStats& s) {
+  printf("Edges: %lld (%.1lf MB) in %.3lfs, %.2lf M edges/s\n", s.edges,
+         s.bytes / 1e6, s.seconds, s.edges / max(s.seconds, 1e-9) / 1e6);
+  printf("Components: %d, giant component: %d\n", s.components, s.giant);
+  if(s.rejected) printf("Rejected lines: %lld\n", s.rejected);
+}
+
+int main(int argc, char** argv) {
+  // usage: streaming-connectivity [<n> <file> [text]]
+  if(argc >= 3) {
+    int n = atoi(argv[1]);
+    UnionFind uf(n);
+    StreamStats s = streamComponents(argv[2], n, argc < 4, uf);
+    if(!s.ok) { fprintf(stderr, "Could not read %s\n", argv[2]); return 1; }
+    report(s);
+    return 0;
+  }
+
+  // vertices with the same remainder modulo 10 are connected, except 9
+  int n = 100000, m = 3000000;
+  FILE* bin = fopen("/tmp/edges.bin", "wb");
+  FILE* txt = fopen("/tmp/edges.txt", "w");
+  for(int i = 0; i < m; i++) {
+    int u = rand() % n, v = u;
+    if(u % 10 != 9) v = (rand() % (n / 10)) * 10 + u % 10;
+    int e[2] = {u, v};
+    fwrite(e, sizeof(int), 2, bin);
+    fprintf(txt, "%d %d%s", u, v, i + 1 < m ? "\n" : "");
+  }
+  fclose(bin); fclose(txt);
+
+  UnionFind ufBin(n), ufTxt(n);
+  StreamStats sBin = streamComponents("/tmp/edges.bin", n, true, ufBin);
+  StreamStats sTxt = streamComponents("/tmp/edges.txt", n, false, ufTxt);
+  unlink("/tmp/edges.bin"); unlink("/tmp/edges.txt");
+
+  report(sBin);
+  report(sTxt);
+  assert(sBin.edges == m && sTxt.edges == m);
+  assert(sBin.components == 9 + n / 10);
+  assert(sTxt.components == sBin.components);
+  assert(sBin.giant == n / 10);
+
+  // a line too long to parse is skipped, along with nothing else
+  txt = fopen("/tmp/edges.txt", "w");
+  fprintf(txt, "0 1\n");
+  for(int i = 0; i < 3000000; i++) fputc('7', txt);
+  for(int i = 1; i < 9; i++) fprintf(txt, "\n%d %d", i, i + 1);
+  fclose(txt);
+  UnionFind ufLong(10);
+  StreamStats sLong = streamComponents("/tmp/edges.txt", 10, false, ufLong);
+  unlink("/tmp/edges.txt");
+  assert(sLong.ok && sLong.edges == 9 && sLong.rejected == 1);
+  assert(sLong.components == 1);
+
+  // comments, malformed lines and edges out of range are not joined
+  txt = fopen("/tmp/edges.txt", "w");
+  fprintf(txt, "# Nodes: 5 Edges: 7\n%% 6 8\n\n0\t1\r\n-5 3\n2 x\n4 5 6\n"
+          "7a 8\n99999999999 1\n3 100\n 2  3 \n");
+  fclose(txt);
+  UnionFind ufBad(10);
+  StreamStats sBad = streamComponents("/tmp/edges.txt", 10, false, ufBad);
+  unlink("/tmp/edges.txt");
+  assert(sBad.ok && sBad.edges == 2 && sBad.rejected == 6);
+  assert(ufBad.sets == 8 && ufBad.get(5) != ufBad.get(7));
+
+  // a directory can be opened, but not read
+  UnionFind ufDir(n);
+  assert(!streamComponents("/tmp", n, true, ufDir).ok);
+  return 0;
+}
@@ -0,0 +1,315 @@
+/**
+ * Suffix Array with LCP
+ *
+ * Index of a fixed string that allows counting and locating the occurrences of
+ * any pattern without scanning the string again. The suffixes are sorted with
+ * SA-IS (induced sorting), the longest common prefixes between adjacent ones
+ * are found with Kasai's algorithm and patterns are searched with a binary
+ * search that skips characters already known to match (Manber-Myers), using
+ * the LCP between each midpoint and the ends of its search interval.
+ *
+ * The index can be saved to a file and mapped back into memory, so that it
+ * only needs to be built once for a given string.
+ *
+ * Parameters:
+ *   - `str`: the string to index;
+ *   - `pattern`: the pattern to find in the string;
+ *   - `path`: the file where the index is stored.
+ *
+ * Operations:
+ *   - `build(str)` builds the index for `str`, returning `false` and leaving
+ *     it empty if `str` is longer than INT_MAX characters, which is what the
+ *     `int` length stored on disk allows;
+ *   - `count(pattern)` returns the number of occurrences of `pattern`;
+ *   - `range(pattern)` returns the range [`first`, `last`) of positions of
+ *     `sa` whose suffixes start with `pattern`;
+ *   - `save(path)` writes the index to `path`;
+ *   - `load(path)` maps an index written by `save` into memory, returning
+ *     `false` if the file could not be read.
+ *
+ * Complexity:
+ *   - Space: O(n);
+ *   - Time:
+ *       * `build`: O(n);
+ *       * `count`, `range`: O(m + log(n)), with `m == pattern.length()`;
+ *       * `save`: O(n);
+ *       * `load`: O(1), as pages are read on demand.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// sorts the suffixes of `s`, whose values are in [0, upper]
+vector<int> saIs(const vector<int>& s, int upper) {
+  int n = s.size();
+  if(n == 0) return vector<int>();
+  if(n == 1) return vector<int>(1, 0);
+
+  vector<int> sa(n);
+  vector<bool> ls(n);  // whether suffix i is S-type (smaller than suffix i + 1)
+  for(int i = n - 2; i >= 0; i--)
+    ls[i] = s[i] == s[i + 1] ? ls[i + 1] : s[i] < s[i + 1];
+
+  // start of the L-type and S-type suffixes of each bucket
+  vector<int> sumL(upper + 2), sumS(upper + 2);
+  for(int i = 0; i < n; i++) {
+    if(!ls[i]) sumS[s[i]]++;
+    else sumL[s[i] + 1]++;
+  }
+  for(int i = 0; i <= upper; i++) {
+    sumS[i] += sumL[i];
+    sumL[i + 1] += sumS[i];
+  }
+
+  auto induce = [&](const vector<int>& lms) {
+    fill(sa.begin(), sa.end(), -1);
+    vector<int> buf(sumS);
+    for(int d : lms) if(d < n) sa[buf[s[d]]++] = d;
+
+    buf = sumL;
+    sa[buf[s[n - 1]]++] = n - 1;
+    for(int i = 0; i < n; i++) {
+      int v = sa[i];
+      if(v >= 1 && !ls[v - 1]) sa[buf[s[v - 1]]++] = v - 1;
+    }
+    buf = sumL;
+    for(int i = n - 1; i >= 0; i--) {
+      int v = sa[i];
+      if(v >= 1 && ls[v - 1]) sa[--buf[s[v - 1] + 1]] = v - 1;
+    }
+  };
+
+  vector<int> lmsMap(n + 1, -1), lms;
+  for(int i = 1; i < n; i++) {
+    if(!ls[i - 1] && ls[i]) { lmsMap[i] = lms.size(); lms.push_back(i); }
+  }
+  int m = lms.size();
+  induce(lms);
+  if(m == 0) return sa;
+
+  // name the LMS substrings by their sorted order and sort them recursively
+  vector<int> sortedLms;
+  for(int v : sa) if(lmsMap[v] >= 0) sortedLms.push_back(v);
+  vector<int> recS(m);
+  int recUpper = 0;
+  recS[lmsMap[sortedLms[0]]] = 0;
+  for(int i = 1; i < m; i++) {
+    int l = sortedLms[i - 1], r = sortedLms[i];
+    int endL = lmsMap[l] + 1 < m ? lms[lmsMap[l] + 1] : n;
+    int endR = lmsMap[r] + 1 < m ? lms[lmsMap[r] + 1] : n;
+    bool same = endL - l == endR - r;
+    if(same) {
+      while(l < endL && s[l] == s[r]) { l++; r++; }
+      if(l == n || s[l] != s[r]) same = false;
+    }
+    if(!same) recUpper++;
+    recS[lmsMap[sortedLms[i]]] = recUpper;
+  }
+
+  vector<int> recSa = saIs(recS, recUpper);
+  for(int i = 0; i < m; i++) sortedLms[i] = lms[recSa[i]];
+  induce(sortedLms);
+  return sa;
+}
+
+struct SuffixArray {
+  int n = 0;
+  const char* str = NULL;
+  // `lcp[i]` is the LCP of the suffixes `sa[i - 1]` and `sa[i]`; `llcp[i]` and
+  // `rlcp[i]` are the LCPs of `sa[i]` with the left and right ends of the
+  // interval where `i` is the midpoint during the binary search
+  const int *sa = NULL, *lcp = NULL, *llcp = NULL, *rlcp = NULL;
+
+  vector<int> data;
+  string text;
+  void* mapped = NULL;
+  size_t mappedLen = 0;
+
+  SuffixArray() {}
+  SuffixArray(const string& s) { build(s); }
+  ~SuffixArray() { unmap(); }
+
+  // the pointers above point into this object's own `data` or mapping
+  SuffixArray(const SuffixArray&) = delete;
+  SuffixArray& operator=(const SuffixArray&) = delete;
+
+  void unmap() {
+    if(mapped) munmap(mapped, mappedLen);
+    mapped = NULL;
+  }
+
+  // the four arrays are stored one after another, with offsets computed in
+  // `size_t` since they exceed INT_MAX from 512M characters onwards
+  void setPointers(const int* base) {
+    size_t len = n;
+    sa = base; lcp = base + len; llcp = base + 2 * len; rlcp = base + 3 * len;
+  }
+
+  int buildLcpLR(int* ll, int* rl, int l, int r) {
+    if(r - l <= 1) return lcp[r];
+    int mid = l + (r - l) / 2;
+    ll[mid] = buildLcpLR(ll, rl, l, mid);
+    rl[mid] = buildLcpLR(ll, rl, mid, r);
+    return min(ll[mid], rl[mid]);
+  }
+
+  bool build(const string& s) {
+    unmap();
+    if(s.size() > INT_MAX) {
+      data.clear(); text.clear(); n = 0;
+      setPointers(NULL); str = NULL;
+      return false;
+    }
+    text = s; str = text.data(); n = s.size();
+    size_t len = n;
+    data.assign(4 * max(len, (size_t) 1), 0);
+    setPointers(data.data());
+
+    vector<int> chars(s.begin(), s.end());
+    for(int& c : chars) c = (unsigned char) c;
+    vector<int> sorted = saIs(chars, 255);
+    copy(sorted.begin(), sorted.end(), data.begin());
+
+    // Kasai: the LCP drops by at most one when moving to the next suffix
+    vector<int> rank(n);
+    for(int i = 0; i < n; i++) rank[sa[i]] = i;
+    for(int i = 0, k = 0; i < n; i++) {
+      if(k > 0) k--;
+      if(rank[i] == 0) { k = 0; continue; }
+      int j = sa[rank[i] - 1];
+      while(i + k < n && j + k < n && str[i + k] == str[j + k]) k++;
+      data[len + rank[i]] = k;
+    }
+    if(n > 1) buildLcpLR(&data[2 * len], &data[3 * len], 0, n - 1);
+    return true;
+  }
+
+  // LCP of `pattern` and suffix `sa[i]`, starting the comparison at `k`
+  int extend(const string& pattern, int i, int k) {
+    while((size_t) k < pattern.size() && sa[i] + k < n &&
+          pattern[k] == str[sa[i] + k]) k++;
+    return k;
+  }
+
+  // whether suffix `sa[i]` comes before `pattern`, knowing their LCP is `k`;
+  // with `upper`, suffixes starting with `pattern` also come before it
+  bool before(const string& pattern, int i, int k, bool upper) {
+    if((size_t) k == pattern.size()) return upper;
+    if(sa[i] + k == n) return true;
+    return (unsigned char) str[sa[i] + k] < (unsigned char) pattern[k];
+  }
+
+  // first position of `sa` whose suffix does not come before `pattern`
+  int bound(const string& pattern, bool upper) {
+    if(n == 0) return 0;
+    int l = 0, r = n - 1;
+    int lk = extend(pattern, l, 0), rk = extend(pattern, r, 0);
+    if(!before(pattern, l, lk, upper)) return 0;
+    if(before(pattern, r, rk, upper)) return n;
+
+    while(r - l > 1) {
+      int mid = l + (r - l) / 2, k;
+      if(lk >= rk) {
+        if(llcp[mid] > lk) { l = mid; continue; }
+        if(llcp[mid] < lk) { r = mid; rk = llcp[mid]; continue; }
+        k = extend(pattern, mid, lk);
+      } else {
+        if(rlcp[mid] > rk) { r = mid; continue; }
+        if(rlcp[mid] < rk) { l = mid; lk = rlcp[mid]; continue; }
+        k = extend(pattern, mid, rk);
+      }
+      if(before(pattern, mid, k, upper)) { l = mid; lk = k; }
+      else { r = mid; rk = k; }
+    }
+    return r;
+  }
+
+  pair<int, int> range(const string& pattern) {
+    return make_pair(bound(pattern, false), bound(pattern, true));
+  }
+
+  int count(const string& pattern) {
+    pair<int, int> r = range(pattern);
+    return r.second - r.first;
+  }
+
+  // file layout: `n`, the four arrays above and the string itself
+  bool save(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if(!f) return false;
+    bool ok = fwrite(&n, sizeof(int), 1, f) == 1;
+    for(const int* arr : {sa, lcp, llcp, rlcp})
+      ok = ok && fwrite(arr, sizeof(int), n, f) == (size_t) n;
+    ok = ok && fwrite(str, 1, n, f) == (size_t) n;
+    return fclose(f) == 0 && ok;
+  }
+
+  bool load(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return false;
+    struct stat st;
+    if(fstat(fd, &st) < 0 || st.st_size < (off_t) sizeof(int)) {
+      close(fd);
+      return false;
+    }
+
+    void* m = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(m == MAP_FAILED) return false;
+    int len = *(int*) m;
+    if(len < 0 || st.st_size != (off_t) sizeof(int) + 17LL * len) {
+      munmap(m, st.st_size);
+      return false;
+    }
+
+    unmap(); data.clear(); text.clear();
+    mapped = m; mappedLen = st.st_size; n = len;
+    setPointers((const int*) m + 1);
+    str = (const char*) (sa + 4 * (size_t) n);
+    return true;
+  }
+};
+
+// -----------------------------------------------
+
+#include <iostream>
+
+int main() {
+  SuffixArray sa("banana");
+
+  cout << "Expected: 5 3 1 0 4 2" << endl;
+  cout << "  Result: ";
+  for(int i = 0; i < sa.n; i++) cout << sa.sa[i] << " ";
+  cout << endl;
+
+  cout << "Expected: 0 1 3 0 0 2" << endl;
+  cout << "  Result: ";
+  for(int i = 0; i < sa.n; i++) cout << sa.lcp[i] << " ";
+  cout << endl;
+
+  cout << "Count of ana: " << sa.count("ana") << " (expected 2)" << endl;
+  cout << "Count of a: " << sa.count("a") << " (expected 3)" << endl;
+  cout << "Count of nab: " << sa.count("nab") << " (expected 0)" << endl;
+
+  SuffixArray empty;
+  cout << "Count in empty index: " << empty.count("a") << " (expected 0)"
+       << endl;
+
+  sa.save("/tmp/suffix-array.idx");
+  SuffixArray loaded;
+  cout << "Loaded: " << loaded.load("/tmp/suffix-array.idx")
+       << " (expected 1)" << endl;
+  cout << "Count of an: " << loaded.count("an") << " (expected 2)" << endl;
+  unlink("/tmp/suffix-array.idx");
+  return 0;
+}
@@ -4,64 +4,89 @@
  * Data structure that keeps track of a set of elements partitioned into a
  * number of disjoint (non-overlapping) subsets.
  *
+ * Each element stores its parent in `pset`, except for the representative of
+ * each subset, which stores the negated size of the subset instead. Subsets
+ * are merged by size and paths are halved iteratively when searched.
+ *
  * Parameters:
- *   None.
+ *   - `T` (type): the signed integer type used for the elements, `int` by
+ *                 default. Use `long long` for more than 2^31 - 1 elements.
  *
  * Operations:
- *   - `init(int n)` sets the initial state for `n` elements, where each one
+ *   - `init(T n)` sets the initial state for `n` elements, where each one
  *     belongs to its own subset;
- *   - `get(int i)` returns the current subset of element `i`;
- *   - `join(int i, int j)` merges the subsets of elements `i` and `j`;
- *   - `sameSet(int i, int j)` returns if `i` and `j` belong to the same subset.
+ *   - `init(vector<T> parent)` sets the state described by a parent array where
+ *     representatives point to themselves, such as the one returned by
+ *     `afforest`;
+ *   - `get(T i)` returns the current subset of element `i`;
+ *   - `join(T i, T j)` merges the subsets of elements `i` and `j`, returning
+ *     `false` if they were already the same;
+ *   - `sameSet(T i, T j)` returns if `i` and `j` belong to the same subset;
+ *   - `size(T i)` returns the number of elements in the subset of `i`;
+ *   - `sets` holds the current number of subsets.
  *
  * Complexity:
  *   - Space: O(n);
  *   - Time:
- *       * `init`: O(n);
+ *       * `init`: O(n), or amortized O(n * α(n)) from a parent array;
  *       * `get`: Amortized O(α(n)) ≈ O(1);
  *       * `join`: Amortized O(α(n)) ≈ O(1);
- *       * `sameSet`: Amortized O(α(n)) ≈ O(1).
+ *       * `sameSet`: Amortized O(α(n)) ≈ O(1);
+ *       * `size`: Amortized O(α(n)) ≈ O(1).
  */
 
-#define MAXN 1000
+#include <utility>
+#include <vector>
+
+using namespace std;
 
-struct UnionFind {
-  int pset[MAXN];
-  int rank[MAXN];
+template<class T = int> struct UnionFind {
+  vector<T> pset;
+  T sets;
 
   UnionFind() {}
-  UnionFind(int n) {
+  UnionFind(T n) {
     init(n);
   }
 
-  void init(int n) { 
-    for(int i = 0; i < n; i++) {
-      pset[i] = i;
-      rank[i] = 0; 
-    }
+  void init(T n) {
+    pset.assign(n, -1);
+    sets = n;
   }
 
-  int get(int i) {
-    return (pset[i] == i) ? i : (pset[i] = get(pset[i]));
+  void init(const vector<T>& parent) {
+    init(parent.size());
+    for(T i = 0; i < (T) parent.size(); i++)
+      if(parent[i] != i) join(i, parent[i]);
   }
 
-  void join(int i, int j) {
-    int xRoot = get(i);
-    int yRoot = get(j);
-    if (xRoot == yRoot) return;
-    if (rank[xRoot] < rank[yRoot])
-      pset[xRoot] = yRoot;
-    else if (rank[xRoot] > rank[yRoot])
-      pset[yRoot] = xRoot;
-    else {
-      pset[yRoot] = xRoot;
-      rank[xRoot] = rank[xRoot] + 1;
+  T get(T i) {
+    while(pset[i] >= 0) {
+      T p = pset[i];
+      if(pset[p] < 0) return p;
+      i = pset[i] = pset[p];
     }
+    return i;
+  }
+
+  bool join(T i, T j) {
+    T xRoot = get(i);
+    T yRoot = get(j);
+    if (xRoot == yRoot) return false;
+    if (pset[xRoot] > pset[yRoot]) swap(xRoot, yRoot);
+    pset[xRoot] += pset[yRoot];
+    pset[yRoot] = xRoot;
+    sets--;
+    return true;
   }
 
-  bool sameSet(int i, int j) {
+  bool sameSet(T i, T j) {
     return get(i) == get(j);
   }
+
+  T size(T i) {
+    return -pset[get(i)];
+  }
 };
 
 // -----------------------------------------------
@@ -70,7 +95,7 @@ struct UnionFind {
 
 int main() {
   int n = 5;
-  UnionFind uf(n);
+  UnionFind<> uf(n);
 
   for(int i = 0; i < n; i++)
     assert(uf.get(i) == i);
@@ -83,5 +108,24 @@ int main() {
   assert(uf.sameSet(1, 3));
   assert(uf.get(1) == uf.get(3));
 
+  assert(!uf.join(1, 3));
+  assert(uf.size(4) == 3);
+  assert(uf.size(0) == 1);
+  assert(uf.sets == 3);
+
+  UnionFind<> loaded;
+  loaded.init(vector<int>({0, 0, 2, 1, 2}));
+  assert(loaded.sets == 2);
+  assert(loaded.sameSet(3, 0) && loaded.sameSet(4, 2));
+  assert(loaded.size(1) == 3);
+
+  // long chains are not a problem as `get` is not recursive
+  long long m = 1000000;
+  UnionFind<long long> big(m);
+  for(long long i = 1; i < m; i++) big.pset[i - 1] = i;
+  big.pset[m - 1] = -m;
+  assert(big.get(0) == m - 1);
+  assert(big.size(0) == m);
+
   return 0;
 }
@@ -0,0 +1,141 @@
+/**
+ * Weighted Union-Find structure
+ *
+ * Union-find structure that also keeps track of the difference between the
+ * values of any two elements in the same subset, given constraints of the form
+ * "x_i - x_j = d". Joining two elements whose difference is already known
+ * tells whether the new constraint is consistent with the previous ones.
+ *
+ * Each element stores its parent together with the difference from its value
+ * to its parent's (its potential), side by side for cache locality. As in
+ * `UnionFind`, representatives store their negated subset size instead of a
+ * parent, subsets are merged by size and paths are halved iteratively, adding
+ * up the potentials that get skipped.
+ *
+ * Parameters:
+ *   - `G` (type): an abelian group holding the differences. Must implement:
+ *       * A default constructor, returning the identity element;
+ *       * `G operator+(G o)` and `G operator-(G o)`;
+ *       * `bool operator==(G o)`;
+ *   - `T` (type): the signed integer type used for the elements, `int` by
+ *                 default.
+ *
+ * Operations:
+ *   - `init(T n)` sets the initial state for `n` elements, where each one
+ *     belongs to its own subset;
+ *   - `get(T i)` returns the current subset of element `i`;
+ *   - `join(T i, T j, G d)` adds the constraint "x_i - x_j = d", merging the
+ *     subsets of `i` and `j` if needed. Returns `false` if the constraint
+ *     contradicts the known difference between `i` and `j`;
+ *   - `sameSet(T i, T j)` returns if `i` and `j` belong to the same subset;
+ *   - `diff(T i, T j)` returns x_i - x_j, if `i` and `j` are in the same subset.
+ *
+ * Complexity:
+ *   - Space: O(n);
+ *   - Time:
+ *       * `init`: O(n);
+ *       * `get`, `join`, `sameSet`, `diff`: Amortized O(α(n)) ≈ O(1).
+ */
+
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+template<class G, class T = int> struct WeightedUnionFind {
+  struct Node { T p; G d; };  // parent or -(size), and x_i - x_parent
+  vector<Node> pset;
+
+  WeightedUnionFind() {}
+  WeightedUnionFind(T n) {
+    init(n);
+  }
+
+  void init(T n) {
+    pset.assign(n, Node{-1, G()});
+  }
+
+  // returns the representative of `i`, setting `pot` to x_i - x_root
+  T find(T i, G& pot) {
+    pot = G();
+    while(pset[i].p >= 0) {
+      T p = pset[i].p;
+      if(pset[p].p < 0) { pot = pot + pset[i].d; return p; }
+      pset[i].d = pset[i].d + pset[p].d;
+      pset[i].p = pset[p].p;
+      pot = pot + pset[i].d;
+      i = pset[i].p;
+    }
+    return i;
+  }
+
+  T get(T i) {
+    G pot;
+    return find(i, pot);
+  }
+
+  bool join(T i, T j, G d) {
+    G pi, pj;
+    T xRoot = find(i, pi);
+    T yRoot = find(j, pj);
+    if (xRoot == yRoot) return pi - pj == d;
+
+    // x_xRoot - x_yRoot = (x_i - pi) - (x_j - pj)
+    G rootDiff = d - pi + pj;
+    if (pset[xRoot].p > pset[yRoot].p) {
+      pset[yRoot].p += pset[xRoot].p;
+      pset[xRoot] = Node{yRoot, rootDiff};
+    } else {
+      pset[xRoot].p += pset[yRoot].p;
+      pset[yRoot] = Node{xRoot, G() - rootDiff};
+    }
+    return true;
+  }
+
+  bool sameSet(T i, T j) {
+    return get(i) == get(j);
+  }
+
+  G diff(T i, T j) {
+    G pi, pj;
+    find(i, pi); find(j, pj);
+    return pi - pj;
+  }
+};
+
+// -----------------------------------------------
+
+#include <cassert>
+
+// parities under addition modulo 2, for "x_i and x_j are (not) equal"
+struct Parity {
+  bool odd;
+  Parity(bool _odd = false): odd(_odd) {}
+  Parity operator+(Parity o) const { return Parity(odd != o.odd); }
+  Parity operator-(Parity o) const { return Parity(odd != o.odd); }
+  bool operator==(Parity o) const { return odd == o.odd; }
+};
+
+int main() {
+  WeightedUnionFind<long long> uf(5);
+
+  assert(uf.join(0, 1, 3));   // x0 - x1 = 3
+  assert(uf.join(2, 1, -2));  // x2 - x1 = -2
+  assert(uf.diff(0, 2) == 5);
+  assert(uf.diff(2, 0) == -5);
+  assert(uf.join(0, 2, 5));
+  assert(!uf.join(0, 2, 4));
+  assert(!uf.sameSet(0, 3));
+
+  assert(uf.join(3, 4, 10));
+  assert(uf.join(4, 0, 1));
+  assert(uf.diff(3, 1) == 14);
+
+  WeightedUnionFind<Parity> parity(3);
+  assert(parity.join(0, 1, Parity(true)));
+  assert(parity.join(1, 2, Parity(true)));
+  assert(parity.diff(0, 2) == Parity(false));
+  assert(!parity.join(0, 2, Parity(true)));
+
+  return 0;
+}